@@ -0,0 +1,759 @@
+#ifndef BTREE_H
+#define BTREE_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Ordered sets and maps in wide nodes
+//
+// std::set and std::map are red-black trees: one heap node per element, and a
+// lookup in a million Widgets follows some twenty pointers to nodes scattered
+// over the heap, nearly every one a cache miss.
+//
+// btree_set and btree_map keep the same ordering and interface but store many
+// elements per node. The nodes are NodeBytes large, a few cache lines (the
+// default 256) or a whole page (4096), so the tree is only three or four levels
+// deep, the keys of a node are searched within one contiguous array, and
+// elements are allocated a node at a time.
+//
+// It is a B+ tree: all elements live in the leaves, which are linked in order,
+// so iteration and range queries (lower_bound/upper_bound/equal_range) walk
+// leaf arrays rather than climbing up and down the tree. Inner nodes only hold
+// copies of keys to route the search. Keys and mapped values are kept in
+// separate arrays inside a leaf so that a search touches keys only.
+//
+// Constructing from sorted input with the sorted_unique tag, or assign_sorted,
+// fills the leaves one after the other and builds the inner levels above them
+// in O(n), without a single search.
+//
+// The price of storing elements in arrays: inserting moves elements within a
+// node and splitting moves them to another one, so, unlike std::map, insertions
+// invalidate iterators and references, and so does erase. Keys and mapped
+// values must be default constructible and move assignable. erase removes an
+// element from its leaf without merging nodes that run low; a node is only
+// freed when it becomes empty, so a tree that shrinks a lot keeps sparse
+// leaves until it is rebuilt, e.g. by assign_sorted(copy.begin(), copy.end()).
+//
+// Because keys and values are separate, *it for a btree_map is not a
+// std::pair<const Key, T>& but a std::pair<const Key&, T&> proxy, in the manner
+// of std::vector<bool>::reference (use_explicitly_typed_initializer01.cpp):
+// it->first, it->second and auto [k, v] = *it work, and a copy made with auto
+// still refers into the map.
+
+namespace btree_detail {
+
+struct sorted_unique_t { explicit sorted_unique_t() = default; };
+
+template<typename T> struct mapped_size { static constexpr std::size_t value = sizeof(T); };
+template<> struct mapped_size<void> { static constexpr std::size_t value = 0; };
+
+// the mapped values of a leaf; sets have none
+template<typename T, std::size_t N>
+struct slots {
+   T v[N];
+
+   T& operator[](std::size_t i) noexcept { return v[i]; }
+   const T& operator[](std::size_t i) const noexcept { return v[i]; }
+
+   void shiftRight(std::size_t i, std::size_t count)
+   {
+      std::move_backward(v + i, v + count, v + count + 1);
+   }
+
+   void moveTo(slots& dst, std::size_t dstPos, std::size_t first, std::size_t last)
+   {
+      std::move(v + first, v + last, dst.v + dstPos);
+   }
+
+   // removes v[i] of count values; the freed last slot is reset
+   void erase(std::size_t i, std::size_t count)
+   {
+      std::move(v + i + 1, v + count, v + i);
+      v[count - 1] = T();
+   }
+
+   template<typename... Args>
+   void emplace(std::size_t i, Args&&... args) { v[i] = T(std::forward<Args>(args)...); }
+};
+
+template<std::size_t N>
+struct slots<void, N> {
+   void shiftRight(std::size_t, std::size_t) noexcept {}
+   void moveTo(slots&, std::size_t, std::size_t, std::size_t) noexcept {}
+   void erase(std::size_t, std::size_t) noexcept {}
+   void emplace(std::size_t) noexcept {}
+};
+
+// it->first and it->second for an iterator whose reference is a pair of references
+template<typename Reference>
+struct arrow_proxy {
+   Reference r;
+   const Reference* operator->() const noexcept { return &r; }
+};
+
+template<typename Key, typename Mapped, typename Compare, std::size_t NodeBytes>
+class btree {
+   static constexpr std::size_t header = 32;
+
+public:
+   // elements per leaf and keys per inner node
+   static constexpr std::size_t leafCapacity =
+      std::max<std::size_t>(4, (NodeBytes - header) / (sizeof(Key) + mapped_size<Mapped>::value));
+   static constexpr std::size_t innerCapacity =
+      std::max<std::size_t>(3, (NodeBytes - header) / (sizeof(Key) + sizeof(void*)));
+
+private:
+   static constexpr std::size_t L = leafCapacity;
+   static constexpr std::size_t I = innerCapacity;
+
+   struct node {
+      explicit node(bool isLeaf) noexcept : leaf(isLeaf) {}
+      bool leaf;
+      std::size_t count = 0;
+   };
+
+   struct alignas(64) leaf_node : node {
+      leaf_node() : node(true) {}
+      Key keys[L];
+      slots<Mapped, L> values;
+      leaf_node* prev = nullptr;
+      leaf_node* next = nullptr;
+   };
+
+   // children[i] holds the keys k with keys[i - 1] <= k < keys[i]
+   struct alignas(64) inner_node : node {
+      inner_node() : node(false) {}
+      Key keys[I];
+      node* children[I + 1];
+   };
+
+   template<bool Const, typename M = Mapped>
+   struct access {
+      using value_type = std::pair<Key, M>;
+      using reference = std::pair<const Key&, typename std::conditional<Const, const M&, M&>::type>;
+      using pointer = arrow_proxy<reference>;
+      static reference get(leaf_node* l, std::size_t i) noexcept
+      {
+         return reference(l->keys[i], l->values[i]);
+      }
+      static pointer arrow(leaf_node* l, std::size_t i) noexcept { return pointer{ get(l, i) }; }
+   };
+
+   template<bool Const>
+   struct access<Const, void> {
+      using value_type = Key;
+      using reference = const Key&;
+      using pointer = const Key*;
+      static reference get(leaf_node* l, std::size_t i) noexcept { return l->keys[i]; }
+      static pointer arrow(leaf_node* l, std::size_t i) noexcept { return &l->keys[i]; }
+   };
+
+public:
+   using key_type = Key;
+   using key_compare = Compare;
+   using size_type = std::size_t;
+   using difference_type = std::ptrdiff_t;
+
+   template<bool Const>
+   class iterator_impl {
+      using traits = access<Const>;
+
+   public:
+      using iterator_category = std::bidirectional_iterator_tag;
+      using value_type = typename traits::value_type;
+      using difference_type = std::ptrdiff_t;
+      using reference = typename traits::reference;
+      using pointer = typename traits::pointer;
+
+      iterator_impl() = default;
+
+      // iterator -> const_iterator
+      template<bool C = Const, typename = typename std::enable_if<C>::type>
+      iterator_impl(const iterator_impl<false>& other) noexcept
+         : tree_(other.tree_), leaf_(other.leaf_), i_(other.i_) {}
+
+      reference operator*() const noexcept { return traits::get(leaf_, i_); }
+      pointer operator->() const noexcept { return traits::arrow(leaf_, i_); }
+
+      iterator_impl& operator++() noexcept
+      {
+         if (++i_ == leaf_->count) {
+            leaf_ = leaf_->next;
+            i_ = 0;
+         }
+         return *this;
+      }
+
+      iterator_impl operator++(int) noexcept { iterator_impl t = *this; ++*this; return t; }
+
+      iterator_impl& operator--() noexcept
+      {
+         if (!leaf_) {
+            leaf_ = tree_->last_;
+            i_ = leaf_->count - 1;
+         } else if (i_ == 0) {
+            leaf_ = leaf_->prev;
+            i_ = leaf_->count - 1;
+         } else {
+            --i_;
+         }
+         return *this;
+      }
+
+      iterator_impl operator--(int) noexcept { iterator_impl t = *this; --*this; return t; }
+
+      friend bool operator==(const iterator_impl& a, const iterator_impl& b) noexcept
+      { return a.leaf_ == b.leaf_ && a.i_ == b.i_; }
+      friend bool operator!=(const iterator_impl& a, const iterator_impl& b) noexcept
+      { return !(a == b); }
+
+   private:
+      friend class btree;
+      friend class iterator_impl<!Const>;
+
+      iterator_impl(const btree* tree, leaf_node* leaf, std::size_t i) noexcept
+         : tree_(tree), leaf_(leaf), i_(i)
+      {
+         if (leaf_ && i_ == leaf_->count) {       // one past a leaf: first of the next
+            leaf_ = leaf_->next;
+            i_ = 0;
+         }
+      }
+
+      const btree* tree_ = nullptr;
+      leaf_node* leaf_ = nullptr;                 // nullptr for end()
+      std::size_t i_ = 0;
+   };
+
+   // sets hand out const elements only, as std::set does
+   using iterator = iterator_impl<std::is_void<Mapped>::value>;
+   using const_iterator = iterator_impl<true>;
+
+   btree() = default;
+   explicit btree(const Compare& comp) : comp_(comp) {}
+
+   btree(const btree& other) : comp_(other.comp_) { assign_sorted(other.begin(), other.end()); }
+
+   btree(btree&& other) noexcept
+      : comp_(other.comp_), root_(other.root_), first_(other.first_), last_(other.last_),
+        size_(other.size_)
+   {
+      other.root_ = nullptr;
+      other.first_ = other.last_ = nullptr;
+      other.size_ = 0;
+   }
+
+   btree& operator=(btree other) noexcept
+   {
+      swap(other);
+      return *this;
+   }
+
+   ~btree() { clear(); }
+
+   void swap(btree& other) noexcept
+   {
+      using std::swap;
+      swap(comp_, other.comp_);
+      swap(root_, other.root_);
+      swap(first_, other.first_);
+      swap(last_, other.last_);
+      swap(size_, other.size_);
+   }
+
+   size_type size() const noexcept { return size_; }
+   bool empty() const noexcept { return size_ == 0; }
+   key_compare key_comp() const { return comp_; }
+
+   size_type height() const noexcept
+   {
+      size_type h = 0;
+      for (const node* n = root_; n; n = n->leaf ? nullptr : static_cast<const inner_node*>(n)->children[0])
+         ++h;
+      return h;
+   }
+
+   void clear() noexcept
+   {
+      if (root_) destroy(root_);
+      root_ = nullptr;
+      first_ = last_ = nullptr;
+      size_ = 0;
+   }
+
+   iterator begin() noexcept { return iterator(this, first_, 0); }
+   iterator end() noexcept { return iterator(this, nullptr, 0); }
+   const_iterator begin() const noexcept { return const_iterator(this, first_, 0); }
+   const_iterator end() const noexcept { return const_iterator(this, nullptr, 0); }
+   const_iterator cbegin() const noexcept { return begin(); }
+   const_iterator cend() const noexcept { return end(); }
+
+   iterator find(const Key& key) { return iteratorAt<iterator>(findLeaf(key)); }
+   const_iterator find(const Key& key) const { return iteratorAt<const_iterator>(findLeaf(key)); }
+   bool contains(const Key& key) const { return findLeaf(key).first != nullptr; }
+   size_type count(const Key& key) const { return contains(key) ? 1 : 0; }
+
+   // the first element not less than key
+   iterator lower_bound(const Key& key) { return bound<iterator>(key, false); }
+   const_iterator lower_bound(const Key& key) const { return bound<const_iterator>(key, false); }
+
+   // the first element greater than key
+   iterator upper_bound(const Key& key) { return bound<iterator>(key, true); }
+   const_iterator upper_bound(const Key& key) const { return bound<const_iterator>(key, true); }
+
+   std::pair<iterator, iterator> equal_range(const Key& key)
+   { return { lower_bound(key), upper_bound(key) }; }
+   std::pair<const_iterator, const_iterator> equal_range(const Key& key) const
+   { return { lower_bound(key), upper_bound(key) }; }
+
+   // removes key if present; returns the number of elements removed
+   size_type erase(const Key& key)
+   {
+      if (!root_) return 0;
+      bool emptied = false;
+      if (!eraseFrom(root_, key, emptied)) return 0;
+      --size_;
+      if (emptied) {
+         delete static_cast<leaf_node*>(root_);
+         root_ = nullptr;
+      } else {
+         while (!root_->leaf && root_->count == 0) {    // a root with a single child
+            inner_node* r = static_cast<inner_node*>(root_);
+            root_ = r->children[0];
+            delete r;
+         }
+      }
+      return 1;
+   }
+
+   // removes the element at pos; returns the element after it
+   iterator erase(const_iterator pos)
+   {
+      leaf_node* l = pos.leaf_;
+      const std::size_t i = pos.i_;
+      leaf_node* next = l->next;
+      const bool lastInLeaf = l->count == 1;          // then the leaf goes away
+      erase(l->keys[i]);
+      return lastInLeaf ? iterator(this, next, 0) : iterator(this, l, i);
+   }
+
+   // replaces the contents with [first, last), which must be sorted; equal
+   // neighbours are dropped. Leaves are filled completely. If copying an
+   // element or allocating a node throws, the tree keeps its old contents.
+   template<typename It>
+   void assign_sorted(It first, It last)
+   {
+      btree fresh(comp_);
+      fresh.buildSorted(first, last);
+      swap(fresh);
+   }
+
+protected:
+   // inserts key with a mapped value made from args, unless key is present
+   template<typename... Args>
+   std::pair<iterator, bool> insertUnique(const Key& key, Args&&... args)
+   {
+      if (!root_)
+         root_ = first_ = last_ = new leaf_node;
+      if (full(root_)) {
+         inner_node* r = new inner_node;
+         r->children[0] = root_;
+         splitChild(r, 0);
+         root_ = r;
+      }
+      // split full nodes on the way down, so there is always room for a split below
+      node* n = root_;
+      while (!n->leaf) {
+         inner_node* in = static_cast<inner_node*>(n);
+         std::size_t ci = upperBound(in->keys, in->count, key);
+         if (full(in->children[ci])) {
+            splitChild(in, ci);
+            if (!comp_(key, in->keys[ci])) ++ci;
+         }
+         n = in->children[ci];
+      }
+      leaf_node* l = static_cast<leaf_node*>(n);
+      const std::size_t i = lowerBound(l->keys, l->count, key);
+      if (i < l->count && !comp_(key, l->keys[i]))
+         return { iterator(this, l, i), false };
+      std::move_backward(l->keys + i, l->keys + l->count, l->keys + l->count + 1);
+      l->values.shiftRight(i, l->count);
+      l->keys[i] = key;
+      l->values.emplace(i, std::forward<Args>(args)...);
+      ++l->count;
+      ++size_;
+      return { iterator(this, l, i), true };
+   }
+
+private:
+   // elements of the input to assign_sorted are keys for sets, pairs for maps
+   template<typename T>
+   static const Key& keyOf(const T& x) noexcept { return keyOf(x, std::is_void<Mapped>()); }
+   static const Key& keyOf(const Key& key, std::true_type) noexcept { return key; }
+   template<typename T>
+   static const Key& keyOf(const T& kv, std::false_type) noexcept { return kv.first; }
+
+   // fills an empty tree from sorted input; on an exception it frees every
+   // node it made and leaves the tree empty
+   template<typename It>
+   void buildSorted(It first, It last)
+   {
+      std::vector<node*> level;               // roots of complete subtrees
+      std::vector<node*> up;                  // the level being built above them
+      try {
+         leaf_node* cur = nullptr;
+         for (; first != last; ++first) {
+            const Key& key = keyOf(*first);
+            if (cur) {
+               const Key& prev = cur->keys[cur->count - 1];
+               assert(!comp_(key, prev) && "assign_sorted: input is not sorted");
+               if (!comp_(prev, key)) continue;              // duplicate
+            }
+            if (!cur || cur->count == L) {
+               level.push_back(nullptr);      // room first, so the new leaf is never lost
+               leaf_node* fresh = new leaf_node;
+               level.back() = fresh;
+               fresh->prev = cur;
+               if (cur) cur->next = fresh; else first_ = fresh;
+               cur = fresh;
+            }
+            cur->keys[cur->count] = key;
+            assignMapped(cur, cur->count, *first);
+            ++cur->count;
+            ++size_;
+         }
+         last_ = cur;
+         if (level.empty()) return;
+
+         // don't leave a nearly empty last leaf: share with its neighbour
+         if (level.size() > 1 && cur->count < L / 2) {
+            leaf_node* prev = cur->prev;
+            const std::size_t move = (prev->count - cur->count) / 2;
+            std::move_backward(cur->keys, cur->keys + cur->count, cur->keys + cur->count + move);
+            for (std::size_t i = cur->count; i-- > 0;)
+               cur->values.moveTo(cur->values, i + move, i, i + 1);
+            std::move(prev->keys + prev->count - move, prev->keys + prev->count, cur->keys);
+            prev->values.moveTo(cur->values, 0, prev->count - move, prev->count);
+            prev->count -= move;
+            cur->count += move;
+         }
+
+         std::vector<Key> lows;               // smallest key below each node of level
+         lows.reserve(level.size());
+         for (node* n : level)
+            lows.push_back(static_cast<leaf_node*>(n)->keys[0]);
+
+         while (level.size() > 1) {
+            // as few inner nodes as possible, with the children spread evenly
+            const std::size_t groups = (level.size() + I) / (I + 1);
+            std::vector<Key> upLows;
+            upLows.reserve(groups);
+            up.reserve(groups);
+            std::size_t c = 0;
+            for (std::size_t g = 0; g < groups; ++g) {
+               const std::size_t take = level.size() / groups + (g < level.size() % groups);
+               up.push_back(new inner_node);   // reserved: push_back cannot throw
+               inner_node* in = static_cast<inner_node*>(up.back());
+               in->children[0] = level[c];
+               for (std::size_t j = 1; j < take; ++j) {
+                  in->keys[j - 1] = lows[c + j];
+                  in->children[j] = level[c + j];
+               }
+               in->count = take - 1;
+               upLows.push_back(lows[c]);
+               c += take;
+            }
+            level.swap(up);                    // the nodes of up own those of level now
+            up.clear();
+            lows.swap(upLows);
+         }
+         root_ = level[0];
+      } catch (...) {
+         // level still owns its subtrees; the nodes of up are only freed
+         for (node* n : up)
+            delete static_cast<inner_node*>(n);
+         for (node* n : level)
+            if (n) destroy(n);
+         first_ = last_ = nullptr;
+         size_ = 0;
+         throw;
+      }
+   }
+
+   template<typename T>
+   static void assignMapped(leaf_node* l, std::size_t i, const T& kv)
+   {
+      assignMapped(l, i, kv, std::is_void<Mapped>());
+   }
+   template<typename T>
+   static void assignMapped(leaf_node* l, std::size_t i, const T& kv, std::false_type)
+   { l->values[i] = kv.second; }
+   template<typename T>
+   static void assignMapped(leaf_node*, std::size_t, const T&, std::true_type) noexcept {}
+
+   std::size_t lowerBound(const Key* keys, std::size_t n, const Key& key) const
+   {
+      return static_cast<std::size_t>(std::lower_bound(keys, keys + n, key, comp_) - keys);
+   }
+
+   std::size_t upperBound(const Key* keys, std::size_t n, const Key& key) const
+   {
+      return static_cast<std::size_t>(std::upper_bound(keys, keys + n, key, comp_) - keys);
+   }
+
+   static bool full(const node* n) noexcept { return n->count == (n->leaf ? L : I); }
+
+   // splits the full child ci of p, which has room for one more key
+   void splitChild(inner_node* p, std::size_t ci)
+   {
+      node* child = p->children[ci];
+      node* right;
+      Key separator;
+      if (child->leaf) {
+         leaf_node* l = static_cast<leaf_node*>(child);
+         leaf_node* r = new leaf_node;
+         const std::size_t mid = L / 2;
+         std::move(l->keys + mid, l->keys + L, r->keys);
+         l->values.moveTo(r->values, 0, mid, L);
+         r->count = L - mid;
+         l->count = mid;
+         r->prev = l;
+         r->next = l->next;
+         if (l->next) l->next->prev = r; else last_ = r;
+         l->next = r;
+         separator = r->keys[0];
+         right = r;
+      } else {
+         inner_node* in = static_cast<inner_node*>(child);
+         inner_node* r = new inner_node;
+         const std::size_t mid = I / 2;
+         separator = std::move(in->keys[mid]);
+         std::move(in->keys + mid + 1, in->keys + I, r->keys);
+         std::copy(in->children + mid + 1, in->children + I + 1, r->children);
+         r->count = I - mid - 1;
+         in->count = mid;
+         right = r;
+      }
+      std::move_backward(p->keys + ci, p->keys + p->count, p->keys + p->count + 1);
+      std::copy_backward(p->children + ci + 1, p->children + p->count + 1,
+                         p->children + p->count + 2);
+      p->keys[ci] = std::move(separator);
+      p->children[ci + 1] = right;
+      ++p->count;
+   }
+
+   leaf_node* descend(const Key& key) const
+   {
+      node* n = root_;
+      while (!n->leaf) {
+         const inner_node* in = static_cast<const inner_node*>(n);
+         n = in->children[upperBound(in->keys, in->count, key)];
+      }
+      return static_cast<leaf_node*>(n);
+   }
+
+   // the leaf and index of key, or nullptr
+   std::pair<leaf_node*, std::size_t> findLeaf(const Key& key) const
+   {
+      if (!root_) return { nullptr, 0 };
+      leaf_node* l = descend(key);
+      const std::size_t i = lowerBound(l->keys, l->count, key);
+      if (i < l->count && !comp_(key, l->keys[i])) return { l, i };
+      return { nullptr, 0 };
+   }
+
+   template<typename It>
+   It iteratorAt(std::pair<leaf_node*, std::size_t> pos) const
+   {
+      return It(this, pos.first, pos.second);
+   }
+
+   template<typename It>
+   It bound(const Key& key, bool upper) const
+   {
+      if (!root_) return It(this, nullptr, 0);
+      leaf_node* l = descend(key);
+      const std::size_t i = upper ? upperBound(l->keys, l->count, key)
+                                  : lowerBound(l->keys, l->count, key);
+      return It(this, l, i);
+   }
+
+   // removes key from the subtree at n; emptied is set when n has no elements
+   // left, and the caller then frees n (but not its children, all gone too).
+   // Nodes are not merged when they run low, only removed when empty.
+   bool eraseFrom(node* n, const Key& key, bool& emptied)
+   {
+      if (n->leaf) {
+         leaf_node* l = static_cast<leaf_node*>(n);
+         const std::size_t i = lowerBound(l->keys, l->count, key);
+         if (i == l->count || comp_(key, l->keys[i])) return false;
+         // key may refer to l->keys[i] (erase(pos)); it is not read from here on
+         std::move(l->keys + i + 1, l->keys + l->count, l->keys + i);
+         l->keys[l->count - 1] = Key();
+         l->values.erase(i, l->count);
+         if (--l->count == 0) {
+            if (l->prev) l->prev->next = l->next; else first_ = l->next;
+            if (l->next) l->next->prev = l->prev; else last_ = l->prev;
+            emptied = true;
+         }
+         return true;
+      }
+      inner_node* in = static_cast<inner_node*>(n);
+      const std::size_t ci = upperBound(in->keys, in->count, key);
+      bool childEmptied = false;
+      if (!eraseFrom(in->children[ci], key, childEmptied)) return false;
+      if (childEmptied) {
+         node* child = in->children[ci];
+         if (child->leaf) delete static_cast<leaf_node*>(child);
+         else delete static_cast<inner_node*>(child);
+         if (in->count == 0) {
+            emptied = true;
+         } else {
+            // drop the child and the key that separates it from a neighbour
+            const std::size_t k = ci ? ci - 1 : 0;
+            std::move(in->keys + k + 1, in->keys + in->count, in->keys + k);
+            std::copy(in->children + ci + 1, in->children + in->count + 1, in->children + ci);
+            --in->count;
+         }
+      }
+      return true;
+   }
+
+   static void destroy(node* n) noexcept
+   {
+      if (n->leaf) {
+         delete static_cast<leaf_node*>(n);
+      } else {
+         inner_node* in = static_cast<inner_node*>(n);
+         for (std::size_t i = 0; i <= in->count; ++i)
+            destroy(in->children[i]);
+         delete in;
+      }
+   }
+
+   Compare comp_;
+   node* root_ = nullptr;
+   leaf_node* first_ = nullptr;
+   leaf_node* last_ = nullptr;
+   size_type size_ = 0;
+};
+
+} // namespace btree_detail
+
+using btree_detail::sorted_unique_t;
+constexpr sorted_unique_t sorted_unique{};
+
+template<typename Key, typename Compare = std::less<Key>, std::size_t NodeBytes = 256>
+class btree_set : public btree_detail::btree<Key, void, Compare, NodeBytes> {
+   using base = btree_detail::btree<Key, void, Compare, NodeBytes>;
+
+public:
+   using value_type = Key;
+   using typename base::iterator;
+
+   btree_set() = default;
+   explicit btree_set(const Compare& comp) : base(comp) {}
+
+   btree_set(std::initializer_list<Key> keys, const Compare& comp = Compare()) : base(comp)
+   {
+      insert(keys.begin(), keys.end());
+   }
+
+   template<typename It>
+   btree_set(It first, It last, const Compare& comp = Compare()) : base(comp)
+   {
+      insert(first, last);
+   }
+
+   // bulk load from sorted input
+   template<typename It>
+   btree_set(sorted_unique_t, It first, It last, const Compare& comp = Compare()) : base(comp)
+   {
+      this->assign_sorted(first, last);
+   }
+
+   std::pair<iterator, bool> insert(const Key& key) { return this->insertUnique(key); }
+
+   template<typename It>
+   void insert(It first, It last)
+   {
+      for (; first != last; ++first)
+         insert(*first);
+   }
+};
+
+template<typename Key, typename T, typename Compare = std::less<Key>, std::size_t NodeBytes = 256>
+class btree_map : public btree_detail::btree<Key, T, Compare, NodeBytes> {
+   using base = btree_detail::btree<Key, T, Compare, NodeBytes>;
+
+public:
+   using mapped_type = T;
+   using value_type = std::pair<Key, T>;
+   using typename base::iterator;
+
+   btree_map() = default;
+   explicit btree_map(const Compare& comp) : base(comp) {}
+
+   btree_map(std::initializer_list<value_type> kvs, const Compare& comp = Compare()) : base(comp)
+   {
+      insert(kvs.begin(), kvs.end());
+   }
+
+   template<typename It>
+   btree_map(It first, It last, const Compare& comp = Compare()) : base(comp)
+   {
+      insert(first, last);
+   }
+
+   // bulk load from input sorted by key
+   template<typename It>
+   btree_map(sorted_unique_t, It first, It last, const Compare& comp = Compare()) : base(comp)
+   {
+      this->assign_sorted(first, last);
+   }
+
+   std::pair<iterator, bool> insert(const value_type& kv)
+   {
+      return this->insertUnique(kv.first, kv.second);
+   }
+
+   template<typename It>
+   void insert(It first, It last)
+   {
+      for (; first != last; ++first)
+         this->insertUnique((*first).first, (*first).second);
+   }
+
+   // constructs the mapped value from args only if key is not present
+   template<typename... Args>
+   std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args)
+   {
+      return this->insertUnique(key, std::forward<Args>(args)...);
+   }
+
+   T& operator[](const Key& key) { return (*try_emplace(key).first).second; }
+
+   T& at(const Key& key)
+   {
+      iterator it = this->find(key);
+      if (it == this->end()) throw std::out_of_range("btree_map::at");
+      return (*it).second;
+   }
+
+   const T& at(const Key& key) const
+   {
+      auto it = this->find(key);
+      if (it == this->end()) throw std::out_of_range("btree_map::at");
+      return (*it).second;
+   }
+};
+
+#endif // BTREE_H
@@ -0,0 +1,219 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <chrono>
+#include <random>
+#include <utility>
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+#include <assert.h>
+
+#include "btree.h"
+#include "demo_support.h"
+
+// Widgets in std::map and in a B+ tree
+//
+// prefer_auto_to_explicit_type01.cpp gives Widget an operator<, which is all
+// std::set<Widget> and std::map<Widget, T> need (once the operator is const, as
+// std::less requires). btree_set and btree_map (btree.h) need the same, so
+// they can replace them wherever iterators are not kept across insertions
+// and erasures.
+//
+// We check them against std::set/std::map on random data and then time
+// insertion, lookup, an in-order scan and construction from sorted input for
+// a million Widgets, with 256-byte and 4096-byte nodes.
+
+struct Widget {
+  int i;
+  bool operator<(const Widget& other) const {
+    return i < other.i;
+  }
+  bool operator==(const Widget& other) const {
+    return i == other.i;
+  }
+};
+
+// a key whose copies fail once copiesLeft runs out
+struct Fragile {
+  static inline long copiesLeft = 1L << 40;
+  int i = 0;
+  Fragile() = default;
+  explicit Fragile(int x) : i(x) {}
+  Fragile(const Fragile& other) : i(other.i) { spend(); }
+  Fragile& operator=(const Fragile& other) { spend(); i = other.i; return *this; }
+  Fragile(Fragile&&) = default;
+  Fragile& operator=(Fragile&&) = default;
+  bool operator<(const Fragile& other) const { return i < other.i; }
+  static void spend() {
+    if (copiesLeft-- == 0) throw std::runtime_error("Fragile copy");
+  }
+};
+
+template<typename Map>
+typename std::enable_if<!std::is_same<Map, std::map<Widget, int>>::value, Map>::type
+makeSorted(const std::vector<std::pair<Widget, int>>& sorted)
+{
+   return Map(sorted_unique, sorted.begin(), sorted.end());
+}
+
+template<typename Map>
+typename std::enable_if<std::is_same<Map, std::map<Widget, int>>::value, Map>::type
+makeSorted(const std::vector<std::pair<Widget, int>>& sorted)
+{
+   return Map(sorted.begin(), sorted.end());      // linear for sorted input
+}
+
+template<typename Map>
+void benchmark(const char* name, const std::vector<Widget>& keys,
+               const std::vector<Widget>& probes, const std::vector<std::pair<Widget, int>>& sorted)
+{
+   Map m;
+   double insertMs = timeIt([&] {
+      for (std::size_t i = 0; i < keys.size(); ++i)
+         m.insert({ keys[i], static_cast<int>(i) });
+   });
+   long long found = 0, sum = 0;
+   double lookupMs = timeIt([&] {
+      for (const Widget& w : probes) {
+         auto it = m.find(w);
+         if (it != m.end()) found += (*it).second;
+      }
+   });
+   double scanMs = timeIt([&] {
+      for (const auto& kv : m) sum += kv.first.i;
+   });
+   double bulkMs = timeIt([&] {
+      Map bulk = makeSorted<Map>(sorted);
+      sum += static_cast<long long>(bulk.size());
+   });
+   std::cout << name << ": insert " << insertMs << " ms, lookup " << lookupMs << " ms, scan "
+             << scanMs << " ms, from sorted " << bulkMs << " ms (checksum " << found + sum << ")"
+             << std::endl;
+}
+
+int main(const int argc, const char* argv[])
+{
+   std::mt19937 gen(42);
+   {
+      btree_set<Widget, std::less<Widget>, 128> s;     // small nodes: several levels
+      std::set<Widget> reference;
+      for (int i = 0; i < 20000; ++i) {
+         Widget w{ static_cast<int>(gen() % 50000) };
+         const bool inserted = s.insert(w).second;
+         const bool expected = reference.insert(w).second;
+         assert(inserted == expected);
+         (void)inserted; (void)expected;
+      }
+      assert(s.size() == reference.size() && s.height() > 2);
+      assert(std::equal(s.begin(), s.end(), reference.begin(), reference.end()));
+      assert(std::equal(std::make_reverse_iterator(s.end()), std::make_reverse_iterator(s.begin()),
+                        reference.rbegin(), reference.rend()));
+      for (int k = -1; k <= 50001; k += 7) {
+         Widget w{ k };
+         assert(s.contains(w) == (reference.count(w) == 1));
+         auto lo = s.lower_bound(w);
+         auto hi = s.upper_bound(w);
+         assert(lo == s.end() ? reference.lower_bound(w) == reference.end()
+                              : *lo == *reference.lower_bound(w));
+         assert(hi == s.end() ? reference.upper_bound(w) == reference.end()
+                              : *hi == *reference.upper_bound(w));
+         (void)lo; (void)hi;
+      }
+
+      // a range query: all Widgets in [1000, 2000)
+      std::size_t inRange = 0;
+      for (auto it = s.lower_bound(Widget{ 1000 }); it != s.end() && it->i < 2000; ++it)
+         ++inRange;
+      assert(inRange == static_cast<std::size_t>(std::distance(
+         reference.lower_bound(Widget{ 1000 }), reference.lower_bound(Widget{ 2000 }))));
+
+      // bulk load, with duplicates dropped, and copies
+      std::vector<Widget> sorted(reference.begin(), reference.end());
+      sorted.insert(sorted.begin() + 100, sorted[100]);
+      btree_set<Widget, std::less<Widget>, 128> bulk(sorted_unique, sorted.begin(), sorted.end());
+      assert(std::equal(bulk.begin(), bulk.end(), reference.begin(), reference.end()));
+      bulk.insert(Widget{ -5 });
+      assert(*bulk.begin() == Widget{ -5 } && bulk.size() == reference.size() + 1);
+      btree_set<Widget, std::less<Widget>, 128> copy = bulk;
+      assert(std::equal(copy.begin(), copy.end(), bulk.begin(), bulk.end()));
+
+      // erase by key and by iterator, down to an empty tree and back
+      std::vector<Widget> present(reference.begin(), reference.end());
+      std::shuffle(present.begin(), present.end(), gen);
+      for (std::size_t k = 0; k < present.size() / 2; ++k) {
+         assert(s.erase(present[k]) == 1 && s.erase(present[k]) == 0);
+         reference.erase(present[k]);
+      }
+      assert(s.size() == reference.size());
+      assert(std::equal(s.begin(), s.end(), reference.begin(), reference.end()));
+      assert(std::equal(std::make_reverse_iterator(s.end()), std::make_reverse_iterator(s.begin()),
+                        reference.rbegin(), reference.rend()));
+      for (auto it = s.lower_bound(Widget{ 25000 }); it != s.end();)
+         it = s.erase(it);
+      reference.erase(reference.lower_bound(Widget{ 25000 }), reference.end());
+      assert(std::equal(s.begin(), s.end(), reference.begin(), reference.end()));
+      for (auto it = s.begin(); it != s.end();)
+         it = s.erase(it);
+      assert(s.empty() && s.begin() == s.end() && s.height() == 0);
+      s.insert(Widget{ 7 });
+      assert(s.size() == 1 && *s.begin() == Widget{ 7 });
+   }
+   {
+      // a copy that throws while the leaves, or the inner nodes above them,
+      // are built leaves the tree as it was (and, under ASan, leaks nothing)
+      std::vector<Fragile> sorted;
+      for (int i = 0; i < 1000; ++i) sorted.emplace_back(2 * i);
+      btree_set<Fragile, std::less<Fragile>, 128> s(sorted_unique, sorted.begin(),
+                                                     sorted.begin() + 10);
+      for (long copies : { 500L, 1047L }) {
+         Fragile::copiesLeft = copies;
+         bool threw = false;
+         try {
+            s.assign_sorted(sorted.begin(), sorted.end());
+         } catch (const std::runtime_error&) {
+            threw = true;
+         }
+         Fragile::copiesLeft = 1L << 40;
+         assert(threw && s.size() == 10 && s.contains(Fragile(18)) && !s.contains(Fragile(20)));
+         (void)threw;
+      }
+   }
+   {
+      btree_map<std::string, int> m = { { "b", 2 }, { "a", 1 } };
+      m["c"] = 3;
+      ++m["a"];
+      assert(m.at("a") == 2 && m.size() == 3);
+      for (auto [key, value] : m)                 // proxies: value refers into m
+         value *= 10;
+      assert(m.at("b") == 20 && m.find("c")->second == 30);
+      const bool emplaced = m.try_emplace("b", 7).second;
+      assert(!emplaced && m.at("b") == 20);
+      (void)emplaced;
+      auto next = m.erase(m.find("b"));
+      assert(next->first == "c" && next->second == 30);
+      (void)next;
+      const std::size_t erased = m.erase("a");   // invalidates next
+      assert(erased == 1 && m.size() == 1 && m.begin()->first == "c");
+      (void)erased;
+   }
+
+   const std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+   std::vector<Widget> keys(n), probes(n);
+   for (auto& w : keys) w.i = static_cast<int>(gen());
+   for (std::size_t i = 0; i < n; ++i)
+      probes[i] = i % 2 ? keys[gen() % n] : Widget{ static_cast<int>(gen()) };
+   std::vector<std::pair<Widget, int>> sorted(n);
+   for (std::size_t i = 0; i < n; ++i)
+      sorted[i] = { Widget{ static_cast<int>(2 * i) }, static_cast<int>(i) };
+
+   std::cout << n << " Widgets" << std::endl;
+   benchmark<std::map<Widget, int>>("std::map           ", keys, probes, sorted);
+   benchmark<btree_map<Widget, int>>("btree_map, 256 B  ", keys, probes, sorted);
+   benchmark<btree_map<Widget, int, std::less<Widget>, 4096>>("btree_map, 4096 B ", keys, probes,
+                                                              sorted);
+
+   return 0;
+}
@@ -0,0 +1,318 @@
+#ifndef HUGE_VECTOR_H
+#define HUGE_VECTOR_H
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Vectors of billions of elements
+//
+// prefer_auto_to_explicit_type01.cpp warns that
+//
+//    unsigned sz = v.size();
+//
+// silently drops the upper half of the size on 64-bit systems. With more than
+// 2^32 elements this stops being a portability footnote: every unsigned or int
+// that holds an index or a count is a wrap-around waiting to happen. huge_vector
+// uses std::uint64_t for sizes, indexes and differences everywhere, so that
+// auto sz = v.size() is 64 bits whatever the platform's size_t.
+//
+// At that scale std::vector has other problems too. Growing it allocates a new
+// block and copies every element, briefly needing the old and the new block at
+// once; 5 GB of data means 15 GB of address space and 5 GB of copying. And its
+// memory comes from the general-purpose allocator in 4 KB pages, so scanning it
+// takes a TLB miss every 4 KB.
+//
+// huge_vector takes its memory straight from mmap:
+//
+//  * it grows by mremap, which moves the page table entries to a larger range
+//    of addresses instead of copying the data (Linux; elsewhere it falls back
+//    to map, copy and unmap),
+//
+//  * anonymous mappings are advised to use transparent huge pages (2 MB), so a
+//    scan takes one TLB miss per 2 MB,
+//
+//  * memory the kernel hands out is zero filled, so resize() to a larger size
+//    does not touch the new elements at all: pages are faulted in when they are
+//    first used, and never if they never are,
+//
+//  * with open() it maps a file instead (MAP_SHARED), so the data can be larger
+//    than RAM and persists; the file grows with the vector and is truncated to
+//    its size when the vector is destroyed.
+//
+// Elements are moved around as bytes and new ones start as zero bytes, so T
+// must be trivially copyable (integers, floats, PODs). A huge_vector cannot be
+// copied by accident; it can be moved. Growth invalidates pointers and
+// iterators, as it does for std::vector.
+
+template<typename T>
+class huge_vector {
+   static_assert(std::is_trivially_copyable<T>::value,
+                 "huge_vector moves its elements as bytes");
+
+public:
+   using value_type = T;
+   using size_type = std::uint64_t;
+   using difference_type = std::int64_t;
+   using reference = T&;
+   using const_reference = const T&;
+   using pointer = T*;
+   using const_pointer = const T*;
+   using iterator = T*;
+   using const_iterator = const T*;
+
+   huge_vector() noexcept = default;
+
+   // n zero-initialized elements; no page is touched yet
+   explicit huge_vector(size_type n) { resize(n); }
+
+   huge_vector(size_type n, const T& value) { resize(n, value); }
+
+   // maps the file at path, creating it if necessary; its elements are the
+   // current contents of the file. If that fails the file keeps its elements.
+   static huge_vector open(const std::string& path)
+   {
+      const int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+      if (fd < 0) fail("open " + path);
+      struct stat st;
+      if (::fstat(fd, &st) != 0) {
+         const int error = errno;
+         ::close(fd);
+         errno = error;
+         fail("fstat " + path);
+      }
+      // v owns the file from here on, and truncates it to size_ if reserve
+      // throws, so size_ must already be what the file holds
+      huge_vector v;
+      v.fd_ = fd;
+      v.size_ = v.touched_ = static_cast<size_type>(st.st_size) / sizeof(T);
+      v.reserve(v.size_);
+      return v;
+   }
+
+   huge_vector(const huge_vector&) = delete;
+   huge_vector& operator=(const huge_vector&) = delete;
+
+   huge_vector(huge_vector&& other) noexcept
+      : data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0)),
+        touched_(std::exchange(other.touched_, 0)), bytes_(std::exchange(other.bytes_, 0)),
+        fd_(std::exchange(other.fd_, -1)) {}
+
+   huge_vector& operator=(huge_vector&& other) noexcept
+   {
+      if (this != &other) {
+         release();
+         data_ = std::exchange(other.data_, nullptr);
+         size_ = std::exchange(other.size_, 0);
+         touched_ = std::exchange(other.touched_, 0);
+         bytes_ = std::exchange(other.bytes_, 0);
+         fd_ = std::exchange(other.fd_, -1);
+      }
+      return *this;
+   }
+
+   ~huge_vector() { release(); }
+
+   size_type size() const noexcept { return size_; }
+   size_type capacity() const noexcept { return bytes_ / sizeof(T); }
+   bool empty() const noexcept { return size_ == 0; }
+   bool file_backed() const noexcept { return fd_ >= 0; }
+
+   static constexpr size_type max_size() noexcept
+   {
+      return static_cast<size_type>(std::numeric_limits<difference_type>::max()) / sizeof(T);
+   }
+
+   T* data() noexcept { return data_; }
+   const T* data() const noexcept { return data_; }
+
+   T& operator[](size_type i) noexcept { return data_[i]; }
+   const T& operator[](size_type i) const noexcept { return data_[i]; }
+
+   T& at(size_type i)
+   {
+      if (i >= size_) throw std::out_of_range("huge_vector::at");
+      return data_[i];
+   }
+
+   const T& at(size_type i) const
+   {
+      if (i >= size_) throw std::out_of_range("huge_vector::at");
+      return data_[i];
+   }
+
+   T& front() noexcept { return data_[0]; }
+   const T& front() const noexcept { return data_[0]; }
+   T& back() noexcept { return data_[size_ - 1]; }
+   const T& back() const noexcept { return data_[size_ - 1]; }
+
+   iterator begin() noexcept { return data_; }
+   iterator end() noexcept { return data_ + size_; }
+   const_iterator begin() const noexcept { return data_; }
+   const_iterator end() const noexcept { return data_ + size_; }
+   const_iterator cbegin() const noexcept { return data_; }
+   const_iterator cend() const noexcept { return data_ + size_; }
+
+   void reserve(size_type n)
+   {
+      if (n > max_size()) throw std::length_error("huge_vector::reserve");
+      if (n > capacity()) remap(roundUp(n * sizeof(T)));
+   }
+
+   // new elements are zero bytes
+   void resize(size_type n)
+   {
+      reserve(n);
+      if (n > size_) zeroTouched(size_, n);
+      size_ = n;
+      touched_ = std::max(touched_, n);
+   }
+
+   // value, like the arguments of push_back and emplace_back, may be an element
+   // of this vector, which growing moves; it is copied first
+   void resize(size_type n, const T& value)
+   {
+      const T copy = value;
+      const size_type old = size_;
+      resize(n);
+      if (n > old) std::fill(data_ + old, data_ + n, copy);
+   }
+
+   void clear() noexcept { size_ = 0; }
+
+   void push_back(const T& value)
+   {
+      const T copy = value;
+      if (size_ == capacity()) grow();
+      data_[size_++] = copy;
+      touched_ = std::max(touched_, size_);
+   }
+
+   template<typename... Args>
+   T& emplace_back(Args&&... args)
+   {
+      T value(std::forward<Args>(args)...);
+      if (size_ == capacity()) grow();
+      T* p = ::new (static_cast<void*>(data_ + size_)) T(value);
+      touched_ = std::max(touched_, ++size_);
+      return *p;
+   }
+
+   void pop_back() noexcept { --size_; }
+
+   // gives memory beyond size() back to the system (and truncates the file)
+   void shrink_to_fit()
+   {
+      const size_type bytes = roundUp(size_ * sizeof(T));
+      if (bytes < bytes_) remap(bytes);
+      touched_ = std::min(touched_, capacity());
+   }
+
+   // tells the kernel the data will be read front to back (more read-ahead for
+   // files) or randomly (less)
+   void advise_sequential() const noexcept { advise(MADV_SEQUENTIAL); }
+   void advise_random() const noexcept { advise(MADV_RANDOM); }
+
+   // writes the dirty pages of a file-backed vector to disk
+   void sync() const
+   {
+      if (fd_ >= 0 && bytes_ && ::msync(data_, bytes_, MS_SYNC) != 0) fail("msync");
+   }
+
+private:
+   // mappings grow in steps of whole huge pages
+   static constexpr size_type granule = size_type(2) << 20;
+
+   static size_type roundUp(size_type bytes) noexcept
+   {
+      return (bytes + granule - 1) / granule * granule;
+   }
+
+   [[noreturn]] static void fail(const std::string& what)
+   {
+      throw std::system_error(errno, std::generic_category(), "huge_vector: " + what);
+   }
+
+   void grow()
+   {
+      const size_type cap = capacity();
+      if (cap == max_size()) throw std::length_error("huge_vector::push_back");
+      reserve(std::max<size_type>(cap + cap / 2, granule / sizeof(T)));
+   }
+
+   // zeroes [first, last) where earlier elements may have left data behind
+   void zeroTouched(size_type first, size_type last) noexcept
+   {
+      last = std::min(last, touched_);
+      if (first < last) std::memset(static_cast<void*>(data_ + first), 0, (last - first) * sizeof(T));
+   }
+
+   void advise(int advice) const noexcept
+   {
+      if (bytes_) ::madvise(static_cast<void*>(data_), bytes_, advice);
+   }
+
+   // changes the mapping (and the file) to bytes, keeping the contents
+   void remap(size_type bytes)
+   {
+      if (fd_ >= 0 && ::ftruncate(fd_, static_cast<off_t>(bytes)) != 0) fail("ftruncate");
+      const int share = fd_ >= 0 ? MAP_SHARED : MAP_PRIVATE | MAP_ANONYMOUS;
+      void* p;
+      if (bytes_ == 0) {
+         p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, share | MAP_NORESERVE, fd_, 0);
+         if (p == MAP_FAILED) fail("mmap");
+      } else if (bytes == 0) {
+         ::munmap(static_cast<void*>(data_), bytes_);
+         p = nullptr;
+      } else {
+#if defined(__linux__)
+         p = ::mremap(static_cast<void*>(data_), bytes_, bytes, MREMAP_MAYMOVE);
+         if (p == MAP_FAILED) fail("mremap");
+#else
+         p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, share | MAP_NORESERVE, fd_, 0);
+         if (p == MAP_FAILED) fail("mmap");
+         if (fd_ < 0) std::memcpy(p, static_cast<void*>(data_), std::min(bytes, bytes_));
+         ::munmap(static_cast<void*>(data_), bytes_);
+#endif
+      }
+      data_ = static_cast<T*>(p);
+      bytes_ = bytes;
+#if defined(MADV_HUGEPAGE)
+      if (fd_ < 0 && bytes_) ::madvise(p, bytes_, MADV_HUGEPAGE);
+#endif
+   }
+
+   void release() noexcept
+   {
+      if (data_) ::munmap(static_cast<void*>(data_), bytes_);
+      if (fd_ >= 0) {
+         // the file keeps exactly the elements, not the spare capacity
+         if (::ftruncate(fd_, static_cast<off_t>(size_ * sizeof(T))) != 0) {}
+         ::close(fd_);
+      }
+      data_ = nullptr;
+      size_ = touched_ = bytes_ = 0;
+      fd_ = -1;
+   }
+
+   T* data_ = nullptr;
+   size_type size_ = 0;
+   size_type touched_ = 0;                     // elements beyond this are known to be zero
+   size_type bytes_ = 0;                       // of the mapping
+   int fd_ = -1;
+};
+
+#endif // HUGE_VECTOR_H
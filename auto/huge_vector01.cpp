@@ -0,0 +1,215 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <system_error>
+#include <type_traits>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <assert.h>
+
+#include "demo_support.h"
+#include "huge_vector.h"
+#include "work_stealing_pool.h"
+
+// More than 2^32 elements
+//
+// prefer_auto_to_explicit_type01.cpp shows
+//
+//    unsigned sz = v.size();
+//
+// and explains that it truncates on 64-bit systems. Here it actually happens:
+// a huge_vector (huge_vector.h) of 2^32 + 5 bytes, which costs nothing until it
+// is written, reports 5 through an unsigned and the right size through auto.
+//
+// Then the benchmarks:
+//
+//  * appending 2^30 bytes one push_back at a time to a std::vector and to a
+//    huge_vector, which grows by mremap instead of copying, and
+//
+//  * filling and scanning `elements` one-byte elements (5 billion by default),
+//    sequentially and with parallel_for on a work_stealing_pool. When that is
+//    more than about half of the RAM, the vector is backed by a file instead
+//    (the second argument, or huge_vector01.bin in the current directory, which
+//    is removed afterwards).
+
+using Bytes = huge_vector<std::uint8_t>;
+
+// opens path with the address space capped a little above what is in use, so
+// that mapping the file fails; false if that could not be arranged
+bool openFailsWithoutAddressSpace(const std::string& path)
+{
+   long pages = 0;
+   if (std::FILE* statm = std::fopen("/proc/self/statm", "r")) {
+      if (std::fscanf(statm, "%ld", &pages) != 1) pages = 0;
+      std::fclose(statm);
+   }
+   rlimit old;
+   if (pages <= 0 || getrlimit(RLIMIT_AS, &old) != 0) return false;
+   rlimit capped = old;
+   capped.rlim_cur = static_cast<rlim_t>(pages) * static_cast<rlim_t>(sysconf(_SC_PAGESIZE)) +
+                     (rlim_t(16) << 20);
+   if (capped.rlim_cur > old.rlim_cur || setrlimit(RLIMIT_AS, &capped) != 0) return false;
+   bool failed = false;
+   try {
+      huge_vector<std::uint64_t>::open(path);
+   } catch (const std::system_error&) {
+      failed = true;
+   }
+   setrlimit(RLIMIT_AS, &old);
+   return failed;
+}
+
+int main(const int argc, const char* argv[])
+{
+   const std::uint64_t elements = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 5000000000ull;
+   const bool fileGiven = argc > 2;
+   const std::string path = fileGiven ? argv[2] : "huge_vector01.bin";
+
+   {
+      Bytes v(std::uint64_t(1) << 32 | 5);
+      unsigned sz = v.size();                  // truncated
+      auto sz2 = v.size();                     // std::uint64_t
+      static_assert(std::is_same<decltype(sz2), std::uint64_t>::value, "");
+      assert(sz == 5 && sz2 == 4294967301ull);
+      v[sz2 - 1] = 42;                         // past 2^32, and not v[4]
+      assert(v[sz2 - 1] == 42 && v[4] == 0 && v.at(sz2 - 1) == 42);
+      (void)sz; (void)sz2;
+
+      Bytes w;
+      for (int i = 0; i < 5000000; ++i)
+         w.push_back(static_cast<std::uint8_t>(i));
+      w.resize(10);
+      w.resize(3000000);                       // elements that come back are zero
+      assert(w[9] == 9 && w[10] == 0 && w[2999999] == 0);
+      w.shrink_to_fit();
+      assert(w.capacity() >= w.size() && w[9] == 9);
+      Bytes moved = std::move(w);
+      assert(w.empty() && moved.size() == 3000000);
+
+      // appending an element of the vector itself while it grows
+      huge_vector<std::uint64_t> g;
+      g.push_back(11);
+      while (g.size() < g.capacity()) g.push_back(g.size());
+      const std::uint64_t first = g.size();
+      g.push_back(g[0]);
+      while (g.size() < g.capacity()) g.push_back(g.size());
+      const std::uint64_t second = g.size();
+      g.emplace_back(g[first]);
+      while (g.size() < g.capacity()) g.push_back(g.size());
+      const std::uint64_t third = g.size();
+      g.resize(third + 2, g[second]);
+      assert(g[first] == 11 && g[second] == 11 && g[third] == 11 && g[third + 1] == 11);
+      (void)first; (void)second; (void)third;
+
+      const std::string small = path + ".small";
+      {
+         huge_vector<std::uint64_t> f = huge_vector<std::uint64_t>::open(small);
+         assert(f.file_backed() && f.empty());
+         for (std::uint64_t i = 0; i < 1000; ++i) f.push_back(i * i);
+      }
+      {
+         huge_vector<std::uint64_t> f = huge_vector<std::uint64_t>::open(small);
+         assert(f.size() == 1000 && f[999] == 999 * 999);
+         f.resize(500);
+      }
+      {
+         huge_vector<std::uint64_t> f = huge_vector<std::uint64_t>::open(small);
+         assert(f.size() == 500 && f.back() == 499 * 499);
+      }
+      std::remove(small.c_str());
+
+      // an open that fails after the file is opened must not truncate it
+      const std::string big = path + ".big";
+      const std::uint64_t bigSize = std::uint64_t(8) << 20;   // 64 MB
+      std::remove(big.c_str());
+      {
+         huge_vector<std::uint64_t> f = huge_vector<std::uint64_t>::open(big);
+         f.resize(bigSize);
+         f.back() = 42;
+      }
+      const bool failed = openFailsWithoutAddressSpace(big);
+      {
+         huge_vector<std::uint64_t> f = huge_vector<std::uint64_t>::open(big);
+         assert(f.size() == bigSize && f.back() == 42);
+      }
+      std::remove(big.c_str());
+      std::cout << "open with too little address space "
+                << (failed ? "failed and kept the file" : "could not be tried") << std::endl;
+   }
+
+   {
+      const std::uint64_t n = std::uint64_t(1) << 30;
+      std::vector<std::uint8_t> sv;
+      Bytes hv;
+      const double stdMs = timeIt([&] {
+         for (std::uint64_t i = 0; i < n; ++i) sv.push_back(static_cast<std::uint8_t>(i));
+      });
+      const double hugeMs = timeIt([&] {
+         for (std::uint64_t i = 0; i < n; ++i) hv.push_back(static_cast<std::uint8_t>(i));
+      });
+      assert(sv.size() == hv.size() && std::equal(sv.begin(), sv.end(), hv.begin()));
+      std::cout << "push_back of 2^30 bytes: std::vector " << stdMs << " ms, huge_vector "
+                << hugeMs << " ms" << std::endl;
+   }
+
+   const std::uint64_t ram = static_cast<std::uint64_t>(sysconf(_SC_PHYS_PAGES)) *
+                             static_cast<std::uint64_t>(sysconf(_SC_PAGESIZE));
+   const bool useFile = fileGiven || elements > ram / 2;
+   Bytes v;
+   if (useFile) {
+      std::remove(path.c_str());
+      v = Bytes::open(path);
+   }
+   const double fillMs = timeIt([&] {
+      v.resize(elements);
+      std::uint8_t* p = v.data();
+      for (std::uint64_t i = 0; i < elements; ++i)
+         p[i] = static_cast<std::uint8_t>(i % 251);
+   });
+   v.advise_sequential();
+
+   std::uint64_t count = 0, sum = 0;
+   const double countMs = timeIt([&] { count = std::count(v.begin(), v.end(), 7); });
+   const double sumMs = timeIt([&] {
+      for (std::uint8_t b : v) sum += b;
+   });
+
+   work_stealing_pool pool;
+   const std::uint64_t chunk = std::uint64_t(64) << 20;
+   const std::uint64_t chunks = (elements + chunk - 1) / chunk;
+   std::atomic<std::uint64_t> parallelCount{ 0 };
+   const double parallelMs = timeIt([&] {
+      pool.parallel_for(std::uint64_t(0), chunks, [&](std::uint64_t c) {
+         const std::uint8_t* first = v.data() + c * chunk;
+         const std::uint8_t* last = v.data() + std::min(elements, (c + 1) * chunk);
+         parallelCount.fetch_add(static_cast<std::uint64_t>(std::count(first, last, 7)),
+                                 std::memory_order_relaxed);
+      }, std::uint64_t(1));
+   });
+
+   // i % 251 == 7 for i = 7, 258, ...; the bytes of a full cycle add up to 250 * 251 / 2
+   const std::uint64_t expectedCount = elements / 251 + (elements % 251 > 7);
+   const std::uint64_t r = elements % 251;
+   const std::uint64_t expectedSum = elements / 251 * (250 * 251 / 2) + r * (r - (r > 0)) / 2;
+   assert(count == expectedCount && parallelCount == expectedCount && sum == expectedSum);
+   (void)expectedCount; (void)expectedSum;
+
+   const double gb = static_cast<double>(elements) / 1e9;
+   std::cout << elements << " bytes" << (useFile ? " in " + path : std::string(" in memory"))
+             << ": fill " << fillMs << " ms, count " << countMs << " ms (" << gb / countMs * 1000
+             << " GB/s), sum " << sumMs << " ms, parallel count on " << pool.size()
+             << " workers " << parallelMs << " ms (" << gb / parallelMs * 1000 << " GB/s); "
+             << count << " sevens, sum " << sum << std::endl;
+
+   if (useFile && !fileGiven) {
+      v = Bytes();
+      std::remove(path.c_str());
+   }
+   return 0;
+}
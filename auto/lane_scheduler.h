@@ -0,0 +1,227 @@
+#ifndef LANE_SCHEDULER_H
+#define LANE_SCHEDULER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "latency_histogram.h"
+
+// Work queues with priority lanes
+//
+// processWidget(w, highPriority) in use_explicitly_typed_initializer01.cpp is
+// told whether a Widget is urgent, but by the time it runs, the Widget has
+// already waited in the same queue as everything else. Priority only helps if
+// it decides what runs next.
+//
+// lane_scheduler keeps one FIFO per lane and a pool of workers that take items
+// from the lanes and pass them to a handler. Which lane a worker serves next is
+// decided by
+//
+//  * weights: while several lanes have work, lane i is served weight_i times
+//    out of every sum(weights) picks (smooth weighted round robin, so the picks
+//    are interleaved rather than bursty), and
+//
+//  * starvation protection: a lane that has had work but has not been served
+//    for longer than its maxWait is served next, whatever the weights say. With
+//    very uneven weights (1000:1, close to strict priority) this bounds the gap
+//    between services of the light lane. It is deliberately about the lane, not
+//    about the age of its oldest item: under overload every item of a backed up
+//    lane is old, and serving old items first would hand the heavy lanes'
+//    share to the light one.
+//
+// Every lane has a capacity. Under overload push fails instead of letting the
+// queue, and with it the latency, grow without bound; the caller decides
+// whether to drop, retry or degrade.
+//
+// For each lane the scheduler records how long items waited between push and
+// the moment a worker took them in a latency_histogram (latency_histogram.h),
+// and stats reports p50, p99 and the maximum. The histogram has a fixed size,
+// so a scheduler that runs for days records its millionth item as cheaply as
+// its first, and stats copies the same 30 KB however many there were.
+
+template<typename T>
+class lane_scheduler {
+public:
+   using clock = std::chrono::steady_clock;
+
+   struct lane_options {
+      unsigned weight = 1;
+      clock::duration maxWait = clock::duration::max();
+      std::size_t capacity = std::numeric_limits<std::size_t>::max();
+   };
+
+   struct lane_stats {
+      std::size_t processed = 0;
+      std::size_t rejected = 0;
+      std::size_t starvationPicks = 0;       // services forced by maxWait
+      clock::duration p50{}, p99{}, max{};   // queueing latency
+   };
+
+   // handler(item, lane) runs on a worker thread
+   lane_scheduler(std::vector<lane_options> lanes, unsigned workers,
+                  std::function<void(T&, std::size_t)> handler)
+      : handler_(std::move(handler))
+   {
+      if (lanes.empty() || workers == 0)
+         throw std::invalid_argument("lane_scheduler needs at least one lane and one worker");
+      for (const lane_options& o : lanes) {
+         if (o.weight == 0)
+            throw std::invalid_argument("lane_scheduler: lane weights must be positive");
+         lanes_.emplace_back(o);
+      }
+      workers_.reserve(workers);
+      for (unsigned i = 0; i < workers; ++i)
+         workers_.emplace_back([this] { work(); });
+   }
+
+   lane_scheduler(const lane_scheduler&) = delete;
+   lane_scheduler& operator=(const lane_scheduler&) = delete;
+
+   ~lane_scheduler() { close(); }
+
+   std::size_t lanes() const noexcept { return lanes_.size(); }
+
+   // false if the lane is full or the scheduler closed
+   bool push(std::size_t lane, T item)
+   {
+      {
+         std::lock_guard<std::mutex> lock(mutex_);
+         Lane& l = lanes_.at(lane);
+         if (closed_ || l.queue.size() >= l.options.capacity) {
+            ++l.stats.rejected;
+            return false;
+         }
+         const clock::time_point now = clock::now();
+         if (l.queue.empty()) l.waitingSince = now;
+         l.queue.push_back(Entry{ std::move(item), now });
+      }
+      ready_.notify_one();
+      return true;
+   }
+
+   // stops accepting items, lets the workers drain the lanes and joins them
+   void close()
+   {
+      {
+         std::lock_guard<std::mutex> lock(mutex_);
+         closed_ = true;
+      }
+      ready_.notify_all();
+      for (std::thread& t : workers_)
+         if (t.joinable()) t.join();
+   }
+
+   lane_stats stats(std::size_t lane) const
+   {
+      latency_histogram waits;
+      lane_stats s;
+      {
+         std::lock_guard<std::mutex> lock(mutex_);
+         const Lane& l = lanes_.at(lane);
+         s = l.stats;
+         waits = l.waits;
+      }
+      s.p50 = fromNanoseconds(waits.percentile(50));
+      s.p99 = fromNanoseconds(waits.percentile(99));
+      s.max = fromNanoseconds(waits.max());
+      return s;
+   }
+
+private:
+   struct Entry {
+      T item;
+      clock::time_point enqueued;
+   };
+
+   struct Lane {
+      explicit Lane(const lane_options& o) : options(o) {}
+      lane_options options;
+      std::deque<Entry> queue;
+      long long credit = 0;                  // smooth weighted round robin
+      clock::time_point waitingSince;        // last service, or when the lane filled
+      lane_stats stats;
+      latency_histogram waits;               // nanoseconds
+   };
+
+   static clock::duration fromNanoseconds(std::uint64_t ns)
+   {
+      return std::chrono::duration_cast<clock::duration>(
+         std::chrono::nanoseconds(static_cast<std::chrono::nanoseconds::rep>(ns)));
+   }
+
+   // the lane to serve next, or lanes_.size() if all are empty; mutex_ held
+   std::size_t pick(clock::time_point now)
+   {
+      // overdue lanes first, the longest neglected one
+      std::size_t best = lanes_.size();
+      clock::duration worst = clock::duration::min();
+      for (std::size_t i = 0; i < lanes_.size(); ++i) {
+         const Lane& l = lanes_[i];
+         if (l.queue.empty() || l.options.maxWait == clock::duration::max()) continue;
+         const clock::duration overdue = now - l.waitingSince - l.options.maxWait;
+         if (overdue > clock::duration::zero() && overdue > worst) {
+            worst = overdue;
+            best = i;
+         }
+      }
+      if (best != lanes_.size()) {
+         ++lanes_[best].stats.starvationPicks;
+         return best;
+      }
+
+      // every non-empty lane earns its weight, the richest is served and pays the total
+      long long total = 0;
+      for (std::size_t i = 0; i < lanes_.size(); ++i) {
+         Lane& l = lanes_[i];
+         if (l.queue.empty()) continue;
+         l.credit += l.options.weight;
+         total += l.options.weight;
+         if (best == lanes_.size() || l.credit > lanes_[best].credit) best = i;
+      }
+      if (best != lanes_.size()) lanes_[best].credit -= total;
+      return best;
+   }
+
+   void work()
+   {
+      for (;;) {
+         std::unique_lock<std::mutex> lock(mutex_);
+         std::size_t lane;
+         ready_.wait(lock, [&] {
+            lane = pick(clock::now());
+            return lane != lanes_.size() || closed_;
+         });
+         if (lane == lanes_.size()) return;          // closed and drained
+
+         Lane& l = lanes_[lane];
+         Entry e = std::move(l.queue.front());
+         l.queue.pop_front();
+         const clock::time_point now = clock::now();
+         l.waitingSince = now;
+         ++l.stats.processed;
+         l.waits.record(now - e.enqueued);
+         lock.unlock();
+
+         handler_(e.item, lane);
+      }
+   }
+
+   std::function<void(T&, std::size_t)> handler_;
+   mutable std::mutex mutex_;
+   std::condition_variable ready_;
+   std::vector<Lane> lanes_;
+   bool closed_ = false;
+   std::vector<std::thread> workers_;
+};
+
+#endif // LANE_SCHEDULER_H
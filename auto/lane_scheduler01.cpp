@@ -0,0 +1,133 @@
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <atomic>
+#include <thread>
+#include <cstdlib>
+#include <assert.h>
+
+#include "lane_scheduler.h"
+
+// Acting on features(w)[5]
+//
+// use_explicitly_typed_initializer01.cpp reads the high priority bit of a
+// Widget with the explicitly typed initializer idiom and passes it to
+// processWidget. Here the bit chooses the lane of a lane_scheduler
+// (lane_scheduler.h): lane 0 for high priority Widgets, lane 1 for the rest.
+//
+// Widgets arrive about half again as fast as the workers can process them.
+// We compare one shared FIFO lane, two lanes weighted 4:1, and two lanes
+// weighted 1000:1 (nearly strict priority) where a 5 ms starvation bound keeps
+// the normal lane moving, and print the queueing latency of each lane.
+// Processing a Widget is simulated by a 200 us wait, as for I/O, so that the
+// numbers do not depend on the number of cores.
+
+struct Widget {
+   int id;
+};
+
+std::vector<bool> features(const Widget& w) {
+   // every fifth Widget is high priority
+   return { true, true, false, true, false, w.id % 5 == 0 };
+}
+
+bool processWidget(const Widget& w, bool highPriority) {
+   std::this_thread::sleep_for(std::chrono::microseconds(200));   // the same work either way
+   return highPriority || w.id >= 0;
+}
+
+using Scheduler = lane_scheduler<Widget>;
+
+void printLane(const char* name, const Scheduler::lane_stats& s)
+{
+   using us = std::chrono::microseconds;
+   std::cout << "   " << name << ": processed " << s.processed << ", rejected " << s.rejected
+             << ", p50 " << std::chrono::duration_cast<us>(s.p50).count() << " us, p99 "
+             << std::chrono::duration_cast<us>(s.p99).count() << " us, max "
+             << std::chrono::duration_cast<us>(s.max).count() << " us";
+   if (s.starvationPicks) std::cout << ", " << s.starvationPicks << " starvation picks";
+   std::cout << std::endl;
+}
+
+// offers a batch of Widgets every millisecond, perMs chosen for overload
+void run(const char* title, std::vector<Scheduler::lane_options> lanes, int perMs, int durationMs)
+{
+   const unsigned workers = 4;
+   const bool twoLanes = lanes.size() == 2;
+   Scheduler scheduler(std::move(lanes), workers, [](Widget& w, std::size_t lane) {
+      processWidget(w, lane == 0);
+   });
+
+   auto next = std::chrono::steady_clock::now();
+   for (int ms = 0, id = 0; ms < durationMs; ++ms) {
+      for (int i = 0; i < perMs; ++i, ++id) {
+         Widget w{ id };
+         auto highPriority = static_cast<bool>(features(w)[5]);
+         scheduler.push(twoLanes && !highPriority ? 1 : 0, w);
+      }
+      next += std::chrono::milliseconds(1);
+      std::this_thread::sleep_until(next);
+   }
+   scheduler.close();
+
+   std::cout << title << std::endl;
+   printLane(twoLanes ? "high  " : "all   ", scheduler.stats(0));
+   if (twoLanes) printLane("normal", scheduler.stats(1));
+}
+
+int main(const int argc, const char* argv[])
+{
+   {
+      // while nothing is overdue the weights decide: 3 of every 4 picks
+      std::vector<std::size_t> order;
+      std::atomic<bool> filled{ false };
+      Scheduler s({ { 3 }, { 1 } }, 1, [&](Widget& w, std::size_t lane) {
+         while (w.id < 0 && !filled) {}        // hold the only worker until both lanes are full
+         order.push_back(lane);
+      });
+      s.push(0, Widget{ -1 });
+      while (s.stats(0).processed == 0) {}
+      for (int i = 0; i < 40; ++i) {
+         s.push(0, Widget{ i });
+         s.push(1, Widget{ i });
+      }
+      filled = true;
+      s.close();
+      assert(order.size() == 81);
+      std::size_t high = 0;
+      for (std::size_t i = 1; i <= 40; ++i)
+         high += order[i] == 0;
+      assert(high == 30);
+      const bool pushed = s.push(0, Widget{ 0 });
+      assert(!pushed && s.stats(0).rejected == 1);
+      (void)high; (void)pushed;
+   }
+
+   const int durationMs = argc > 1 ? std::atoi(argv[1]) : 1000;
+   const std::size_t capacity = 1000;
+   const auto forever = Scheduler::clock::duration::max();
+
+   // measure what the workers manage, then offer 1.5 times that
+   int perMs = 1;
+   {
+      std::atomic<int> done{ 0 };
+      Scheduler probe({ {} }, 4, [&](Widget& w, std::size_t) { processWidget(w, false); ++done; });
+      for (int id = 0; id < 4000; ++id)
+         probe.push(0, Widget{ id });
+      const auto start = std::chrono::steady_clock::now();
+      probe.close();
+      const double ms = std::chrono::duration<double, std::milli>(
+         std::chrono::steady_clock::now() - start).count();
+      perMs = static_cast<int>(1.5 * done / ms) + 1;
+   }
+   std::cout << "offering " << perMs << " Widgets per ms" << std::endl;
+
+   run("one FIFO lane", { { 1, forever, 2 * capacity } }, perMs, durationMs);
+   run("high:normal = 4:1", { { 4, forever, capacity }, { 1, forever, capacity } },
+       perMs, durationMs);
+   run("high:normal = 1000:1, normal lane served at least every 5 ms",
+       { { 1000, forever, capacity }, { 1, std::chrono::milliseconds(5), capacity } },
+       perMs, durationMs);
+
+   return 0;
+}
@@ -0,0 +1,314 @@
+#ifndef PACKED_INT_VECTOR_H
+#define PACKED_INT_VECTOR_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+
+#include "cpu_dispatch.h"
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "packed_int_vector assumes a little-endian target"
+#endif
+
+// std::vector<bool> for k-bit integers
+//
+// use_explicitly_typed_initializer01.cpp explains how std::vector<bool> stores
+// one bit per element and hands out std::vector<bool>::reference proxies from
+// operator[]. packed_int_vector does the same for integers of any width from 1
+// to 32 bits, chosen at run time: a column of IDs below 2^20 takes 20 bits per
+// element instead of 32, an enum with six values takes 3.
+//
+// Element i occupies bits [i*k, i*k + k) of a little-endian bit stream. Since
+// k <= 32, those bits always lie within the 8 bytes starting at byte i*k/8, so
+//
+//    value = (load64(bytes + i*k/8) >> (i*k % 8)) & mask
+//
+// reads any element with one unaligned load, a shift and an and. The storage
+// is padded so that this load never runs past the end.
+//
+// The proxy returned by the non-const operator[] is where std::vector<bool>
+// lets you down: `auto b = features(w)[5];` keeps a pointer into a temporary.
+// packed_int_vector::reference holds the container and the index rather than
+// a raw word pointer, so it survives reallocation, and its conversion and
+// assignment operators only work on rvalues. It can be used where it is
+// produced, v[i] = 7 or std::uint32_t x = v[i], but a named copy, as auto would
+// make one, cannot be read or written through at all.
+//
+// For bulk work unpack and pack convert ranges of elements to and from plain
+// std::uint32_t buffers. On CPUs with AVX2 unpack decodes eight elements per
+// step (packed_int_vector_detail::unpack, chosen at run time by cpu_dispatch.h).
+// pack stays scalar: it fills whole words in a register and stores each once,
+// and without a scatter the AVX2 version would need a gather per element to
+// merge the neighbours of every word, which is no faster.
+
+namespace packed_int_vector_detail {
+
+#if CPU_DISPATCH_X86
+// decodes the first count / 8 * 8 elements from element first on; returns how
+// many it did
+CPU_DISPATCH_AVX2 inline std::size_t unpackAvx2(const std::uint64_t* words, unsigned bits,
+                                                std::uint32_t mask, std::size_t first,
+                                                std::size_t count, std::uint32_t* out) noexcept
+{
+   // gathered with scale 1, so the indices are byte offsets
+   const long long* base = reinterpret_cast<const long long*>(words);
+   const __m256i vmask = _mm256_set1_epi64x(mask);
+   const __m256i seven = _mm256_set1_epi64x(7);
+   const __m256i lanes = _mm256_setr_epi64x(0, 1, 2, 3);
+   const __m256i step = _mm256_set1_epi64x(4 * static_cast<long long>(bits));
+   const __m256i pack = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+   __m256i bit = _mm256_add_epi64(_mm256_set1_epi64x(static_cast<long long>(first * bits)),
+                                  _mm256_mul_epu32(lanes, _mm256_set1_epi64x(bits)));
+   std::size_t j = 0;
+   for (; j + 8 <= count; j += 8) {
+      const __m256i bit2 = _mm256_add_epi64(bit, step);
+      const __m256i lo = _mm256_and_si256(
+         _mm256_srlv_epi64(_mm256_i64gather_epi64(base, _mm256_srli_epi64(bit, 3), 1),
+                           _mm256_and_si256(bit, seven)), vmask);
+      const __m256i hi = _mm256_and_si256(
+         _mm256_srlv_epi64(_mm256_i64gather_epi64(base, _mm256_srli_epi64(bit2, 3), 1),
+                           _mm256_and_si256(bit2, seven)), vmask);
+      // low 32 bits of each 64-bit lane: lo -> elements 0..3, hi -> 4..7
+      const __m256i lo32 = _mm256_permutevar8x32_epi32(lo, pack);
+      const __m256i hi32 = _mm256_permutevar8x32_epi32(hi, pack);
+      const __m256i both = _mm256_permute2x128_si256(lo32, hi32, 0x20);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + j), both);
+      bit = _mm256_add_epi64(bit2, step);
+   }
+   return j;
+}
+#endif
+
+// leaves everything to the scalar loop in packed_int_vector::unpack
+inline std::size_t unpackNone(const std::uint64_t*, unsigned, std::uint32_t, std::size_t,
+                              std::size_t, std::uint32_t*) noexcept
+{
+   return 0;
+}
+
+inline cpu_dispatch::dispatched<std::size_t(const std::uint64_t*, unsigned, std::uint32_t,
+                                            std::size_t, std::size_t, std::uint32_t*)>
+   unpack{ "packed_int_vector::unpack", {
+      { cpu_dispatch::cpu_level::scalar, &unpackNone },
+#if CPU_DISPATCH_X86
+      { cpu_dispatch::cpu_level::avx2, &unpackAvx2 },
+#endif
+   } };
+
+} // namespace packed_int_vector_detail
+
+class packed_int_vector {
+public:
+   using value_type = std::uint32_t;
+   using size_type = std::size_t;
+
+   class reference {
+   public:
+      operator std::uint32_t() const&& noexcept { return v_->get(i_); }
+
+      reference&& operator=(std::uint32_t value) && noexcept
+      {
+         v_->set(i_, value);
+         return std::move(*this);
+      }
+
+      reference&& operator=(reference&& other) && noexcept
+      {
+         v_->set(i_, other.v_->get(other.i_));
+         return std::move(*this);
+      }
+
+   private:
+      friend class packed_int_vector;
+      reference(packed_int_vector* v, size_type i) noexcept : v_(v), i_(i) {}
+
+      packed_int_vector* v_;
+      size_type i_;
+   };
+
+   // read-only iteration yields values
+   class const_iterator {
+   public:
+      using iterator_category = std::random_access_iterator_tag;
+      using value_type = std::uint32_t;
+      using difference_type = std::ptrdiff_t;
+      using pointer = void;
+      using reference = std::uint32_t;
+
+      const_iterator() = default;
+
+      std::uint32_t operator*() const noexcept { return v_->get(i_); }
+      std::uint32_t operator[](difference_type n) const noexcept { return v_->get(i_ + n); }
+      const_iterator& operator++() noexcept { ++i_; return *this; }
+      const_iterator operator++(int) noexcept { const_iterator t = *this; ++i_; return t; }
+      const_iterator& operator--() noexcept { --i_; return *this; }
+      const_iterator operator--(int) noexcept { const_iterator t = *this; --i_; return t; }
+      const_iterator& operator+=(difference_type n) noexcept { i_ += n; return *this; }
+      const_iterator& operator-=(difference_type n) noexcept { i_ -= n; return *this; }
+      friend const_iterator operator+(const_iterator it, difference_type n) noexcept
+      { return it += n; }
+      friend const_iterator operator-(const_iterator it, difference_type n) noexcept
+      { return it -= n; }
+      friend difference_type operator-(const const_iterator& a, const const_iterator& b) noexcept
+      { return static_cast<difference_type>(a.i_ - b.i_); }
+      friend bool operator==(const const_iterator& a, const const_iterator& b) noexcept
+      { return a.i_ == b.i_; }
+      friend bool operator!=(const const_iterator& a, const const_iterator& b) noexcept
+      { return a.i_ != b.i_; }
+      friend bool operator<(const const_iterator& a, const const_iterator& b) noexcept
+      { return a.i_ < b.i_; }
+
+   private:
+      friend class packed_int_vector;
+      const_iterator(const packed_int_vector* v, size_type i) noexcept : v_(v), i_(i) {}
+
+      const packed_int_vector* v_ = nullptr;
+      size_type i_ = 0;
+   };
+
+   explicit packed_int_vector(unsigned bits, size_type n = 0)
+      : bits_(checkedBits(bits)), mask_(bits_ == 32 ? 0xFFFFFFFFu : (1u << bits_) - 1)
+   {
+      resize(n);
+   }
+
+   // the smallest width that can hold maxValue
+   static unsigned bitsFor(std::uint32_t maxValue) noexcept
+   {
+      unsigned bits = 1;
+      while (bits < 32 && (maxValue >> bits) != 0)
+         ++bits;
+      return bits;
+   }
+
+   size_type size() const noexcept { return n_; }
+   bool empty() const noexcept { return n_ == 0; }
+   unsigned bits() const noexcept { return bits_; }
+   size_type bytes() const noexcept { return words_.size() * sizeof(std::uint64_t); }
+
+   // new elements are zero
+   void resize(size_type n)
+   {
+      if (n < n_) {
+         for (size_type i = n; i < n_; ++i)      // keep the bits past the end zero
+            set(i, 0);
+      }
+      n_ = n;
+      words_.resize(wordsFor(n), 0);
+   }
+
+   void reserve(size_type n) { words_.reserve(wordsFor(n)); }
+
+   void push_back(std::uint32_t value)
+   {
+      if (wordsFor(n_ + 1) > words_.size())
+         words_.resize(words_.size() < 8 ? 8 : 2 * words_.size(), 0);
+      set(n_++, value);
+   }
+
+   std::uint32_t get(size_type i) const noexcept
+   {
+      const size_type bit = i * bits_;
+      return static_cast<std::uint32_t>(load(bit >> 3) >> (bit & 7)) & mask_;
+   }
+
+   // stores the low bits() bits of value
+   void set(size_type i, std::uint32_t value) noexcept
+   {
+      const size_type bit = i * bits_;
+      const unsigned shift = bit & 7;
+      std::uint64_t w = load(bit >> 3);
+      w &= ~(static_cast<std::uint64_t>(mask_) << shift);
+      w |= static_cast<std::uint64_t>(value & mask_) << shift;
+      store(bit >> 3, w);
+   }
+
+   reference operator[](size_type i) noexcept { return reference(this, i); }
+   std::uint32_t operator[](size_type i) const noexcept { return get(i); }
+
+   std::uint32_t at(size_type i) const
+   {
+      if (i >= n_) throw std::out_of_range("packed_int_vector::at");
+      return get(i);
+   }
+
+   const_iterator begin() const noexcept { return const_iterator(this, 0); }
+   const_iterator end() const noexcept { return const_iterator(this, n_); }
+
+   // out[j] = element first + j, for j in [0, count)
+   void unpack(size_type first, size_type count, std::uint32_t* out) const noexcept
+   {
+      assert(first + count <= n_);
+      size_type j = packed_int_vector_detail::unpack(words_.data(), bits_, mask_, first, count, out);
+      size_type bit = (first + j) * bits_;
+      for (; j < count; ++j, bit += bits_)
+         out[j] = static_cast<std::uint32_t>(load(bit >> 3) >> (bit & 7)) & mask_;
+   }
+
+   // element first + j = in[j], for j in [0, count); grows the vector if needed
+   void pack(const std::uint32_t* in, size_type count, size_type first = 0)
+   {
+      if (first + count > n_) resize(first + count);
+      size_type j = 0;
+      // leading elements until the bit position is 64-bit aligned
+      for (; j < count && ((first + j) * bits_) % 64 != 0; ++j)
+         set(first + j, in[j]);
+      // then accumulate whole words and store them without reading
+      std::uint64_t* word = words_.data() + ((first + j) * bits_) / 64;
+      std::uint64_t acc = 0;
+      unsigned fill = 0;
+      for (; j < count; ++j) {
+         const std::uint64_t v = in[j] & mask_;
+         acc |= v << fill;
+         fill += bits_;
+         if (fill >= 64) {
+            *word++ = acc;
+            fill -= 64;
+            acc = fill ? v >> (bits_ - fill) : 0;
+         }
+      }
+      // the last word is shared with elements we must keep
+      if (fill) {
+         const std::uint64_t low = (std::uint64_t(1) << fill) - 1;
+         *word = (*word & ~low) | acc;
+      }
+   }
+
+private:
+   // validated before mask_ shifts by it
+   static unsigned checkedBits(unsigned bits)
+   {
+      if (bits < 1 || bits > 32)
+         throw std::invalid_argument("packed_int_vector: width must be 1 to 32 bits");
+      return bits;
+   }
+
+   size_type wordsFor(size_type n) const noexcept
+   {
+      return (n * bits_ + 63) / 64 + 1;          // +1: padding for the 8-byte loads
+   }
+
+   std::uint64_t load(size_type byte) const noexcept
+   {
+      std::uint64_t w;
+      std::memcpy(&w, reinterpret_cast<const unsigned char*>(words_.data()) + byte, sizeof w);
+      return w;
+   }
+
+   void store(size_type byte, std::uint64_t w) noexcept
+   {
+      std::memcpy(reinterpret_cast<unsigned char*>(words_.data()) + byte, &w, sizeof w);
+   }
+
+   unsigned bits_;
+   std::uint32_t mask_;
+   size_type n_ = 0;
+   std::vector<std::uint64_t> words_;
+};
+
+#endif // PACKED_INT_VECTOR_H
@@ -0,0 +1,132 @@
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <utility>
+#include <cstdint>
+#include <cstdlib>
+#include <type_traits>
+#include <assert.h>
+
+#include "demo_support.h"
+#include "packed_int_vector.h"
+
+// std::vector<bool> beyond one bit
+//
+// features(w) in use_explicitly_typed_initializer01.cpp returns a
+// std::vector<bool>, one bit per feature. packed_int_vector (packed_int_vector.h)
+// stores k-bit integers the same way, for columns of IDs or enums that would
+// otherwise take 32 bits per element. We check that it round-trips values of
+// every width, that its proxy refuses to be used once named, and compare
+// element-wise access with the bulk unpack/pack against a plain
+// std::vector<std::uint32_t>.
+//
+// The explicitly typed initializer idiom still applies, and is the only way to
+// keep a value:
+//
+//    auto id = static_cast<std::uint32_t>(ids[i]);
+
+int main(const int argc, const char* argv[])
+{
+   using reference = packed_int_vector::reference;
+   static_assert(std::is_convertible<reference, std::uint32_t>::value, "");
+   static_assert(!std::is_convertible<reference&, std::uint32_t>::value,
+                 "a named proxy cannot be read");
+   static_assert(!std::is_assignable<reference&, std::uint32_t>::value,
+                 "a named proxy cannot be written");
+
+   std::mt19937 gen(42);
+   for (unsigned bits = 1; bits <= 32; ++bits) {
+      const std::uint32_t mask = bits == 32 ? 0xFFFFFFFFu : (1u << bits) - 1;
+      std::vector<std::uint32_t> plain(1000);
+      for (auto& x : plain)
+         x = gen() & mask;
+
+      packed_int_vector v(bits);
+      for (auto x : plain)
+         v.push_back(x);
+      assert(v.size() == plain.size());
+      for (std::size_t i = 0; i < plain.size(); ++i)
+         assert(v[i] == plain[i]);
+
+      // bulk unpack from every starting offset within a word
+      std::vector<std::uint32_t> out(plain.size());
+      for (std::size_t first = 0; first < 70; first += 7) {
+         v.unpack(first, plain.size() - first, out.data());
+         for (std::size_t i = first; i < plain.size(); ++i)
+            assert(out[i - first] == plain[i]);
+      }
+
+      // pack into the middle must leave the neighbours alone
+      std::vector<std::uint32_t> patch(300);
+      for (auto& x : patch)
+         x = gen() & mask;
+      v.pack(patch.data(), patch.size(), 333);
+      for (std::size_t i = 0; i < plain.size(); ++i) {
+         const std::uint32_t expected = i >= 333 && i < 633 ? patch[i - 333] : plain[i];
+         assert(v.get(i) == expected);
+      }
+
+      // writes through the proxy, including element to element
+      v[5] = 3 & mask;
+      v[6] = v[5];
+      assert(v[6] == (3 & mask));
+   }
+
+   {
+      // features(w) as a 1-bit packed_int_vector; bit 5 is the priority
+      packed_int_vector features(1);
+      for (bool f : { true, true, false, true, false, true })
+         features.push_back(f);
+      auto highPriority = static_cast<bool>(features[5]);
+      assert(highPriority);
+      assert(packed_int_vector::bitsFor(5) == 3 && packed_int_vector::bitsFor(0) == 1);
+   }
+
+   const std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 20000000;
+   const unsigned bits = 20;                       // IDs below 2^20
+   std::vector<std::uint32_t> plain(n);
+   for (auto& x : plain)
+      x = gen() & ((1u << bits) - 1);
+   packed_int_vector packed(bits);
+   packed.pack(plain.data(), n);
+
+   std::vector<std::uint32_t> idx(n);
+   for (auto& x : idx)
+      x = gen() % n;
+
+   std::uint64_t a = 0, b = 0, c = 0, d = 0;
+   double plainRandomMs = timeIt([&] {
+      for (std::size_t i = 0; i < n; ++i) a += plain[idx[i]];
+   });
+   double packedRandomMs = timeIt([&] {
+      for (std::size_t i = 0; i < n; ++i) b += packed.get(idx[i]);
+   });
+   double plainScanMs = timeIt([&] {
+      for (std::size_t i = 0; i < n; ++i) c += plain[i];
+   });
+   std::vector<std::uint32_t> buffer(4096);
+   double unpackScanMs = timeIt([&] {
+      for (std::size_t i = 0; i < n; i += buffer.size()) {
+         const std::size_t count = n - i < buffer.size() ? n - i : buffer.size();
+         packed.unpack(i, count, buffer.data());
+         for (std::size_t j = 0; j < count; ++j) d += buffer[j];
+      }
+   });
+   packed_int_vector repacked(bits);
+   double packMs = timeIt([&] { repacked.pack(plain.data(), n); });
+   assert(a == b && c == d);
+   for (std::size_t i = 0; i < n; i += 9973)
+      assert(repacked.get(i) == plain[i]);
+
+   std::cout << n << " " << bits << "-bit values: " << plain.size() * sizeof(std::uint32_t)
+             << " bytes plain, " << packed.bytes() << " bytes packed" << std::endl;
+   std::cout << "random access: plain " << plainRandomMs << " ms, packed " << packedRandomMs
+             << " ms" << std::endl;
+   std::cout << "sequential sum: plain " << plainScanMs << " ms, unpack " << unpackScanMs
+             << " ms" << std::endl;
+   std::cout << "pack: " << packMs << " ms" << std::endl;
+   std::cout << "(checksum " << a + b + c + d << ")" << std::endl;
+
+   return 0;
+}
@@ -0,0 +1,128 @@
+#ifndef STRING_CONCAT_H
+#define STRING_CONCAT_H
+
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+
+// Expression templates for string concatenation
+//
+// use_explicitly_typed_initializer01.cpp describes how a Matrix library can make
+//
+//    Matrix sum = m1 + m2 + m3 + m4;
+//
+// efficient by having operator+ return a Sum<Matrix, Matrix> proxy instead of a
+// Matrix. std::string has the same problem: in
+//
+//    std::string r = a + b + c + d;
+//
+// a + b creates a temporary, + c appends to it (and may reallocate), + d again,
+// and the total length is never known in advance.
+//
+// concat(a) + b + c + d instead returns a string_concat<4>, a proxy that only
+// records where the four pieces are. When it is turned into a std::string it
+// adds up their lengths, allocates once and copies each piece once.
+//
+// Being an "invisible" proxy in the sense of that Item, string_concat holds
+// views of its operands, and a string_concat kept in an auto variable could
+// outlive them. So, as recommended there, it is materialized with the
+// explicitly typed initializer idiom:
+//
+//    auto key = static_cast<std::string>(concat("user:") + id + ':' + field);
+//
+// operator+, the conversion, str() and appendTo can only be used on an rvalue
+// string_concat, which keeps a proxy from being used by accident after the
+// statement that built it. A named proxy, `auto p = concat(a) + b;`, compiles,
+// but p.str() does not. That does not make dangling impossible:
+//
+//    auto p = concat(std::string("tmp")) + "x";   // views a dead temporary
+//    std::move(p).str();                          // compiles, reads freed memory
+//
+// It only takes that explicit std::move to get there, where the natural use,
+// materializing the proxy in the full expression that creates it while all
+// of its operands are still alive, needs none.
+
+class concat_piece {
+public:
+   concat_piece(std::string_view s) noexcept : data_(s.data()), size_(s.size()) {}
+   concat_piece(const std::string& s) noexcept : data_(s.data()), size_(s.size()) {}
+   concat_piece(const char* s) noexcept : data_(s), size_(std::strlen(s)) {}
+   concat_piece(char c) noexcept : data_(nullptr), size_(1), ch_(c), isChar_(true) {}
+
+   std::size_t size() const noexcept { return size_; }
+
+   void appendTo(std::string& out) const
+   {
+      if (isChar_)
+         out.push_back(ch_);   // a single char is stored by value: it has no address
+      else
+         out.append(data_, size_);   // data_ may be null for an empty view
+   }
+
+private:
+   const char* data_;
+   std::size_t size_;
+   char ch_ = 0;
+   bool isChar_ = false;
+};
+
+template<std::size_t N>
+class string_concat {
+public:
+   explicit string_concat(const std::array<concat_piece, N>& pieces) noexcept
+      : pieces_(pieces) {}
+
+   string_concat<N + 1> operator+(concat_piece next) && noexcept
+   {
+      return string_concat<N + 1>(extend(next, std::make_index_sequence<N>()));
+   }
+
+   std::size_t size() const noexcept
+   {
+      std::size_t total = 0;
+      for (const auto& p : pieces_)
+         total += p.size();
+      return total;
+   }
+
+   // appends all pieces to out with at most one reallocation; the appends
+   // copy straight into the reserved space, which resize would zero first
+   void appendTo(std::string& out) &&
+   {
+      out.reserve(out.size() + size());
+      for (const auto& p : pieces_)
+         p.appendTo(out);
+   }
+
+   std::string str() &&
+   {
+      std::string result;
+      std::move(*this).appendTo(result);
+      return result;
+   }
+
+   explicit operator std::string() && { return std::move(*this).str(); }
+
+private:
+   template<std::size_t... I>
+   std::array<concat_piece, N + 1> extend(concat_piece next,
+                                          std::index_sequence<I...>) const noexcept
+   {
+      return { { pieces_[I]..., next } };
+   }
+
+   std::array<concat_piece, N> pieces_;
+};
+
+// starts a concatenation: concat(a) + b + ..., or concat(a, b, ...) at once
+template<typename... Pieces>
+string_concat<sizeof...(Pieces)> concat(const Pieces&... pieces) noexcept
+{
+   return string_concat<sizeof...(Pieces)>(
+      std::array<concat_piece, sizeof...(Pieces)>{ { concat_piece(pieces)... } });
+}
+
+#endif // STRING_CONCAT_H
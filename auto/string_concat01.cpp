@@ -0,0 +1,103 @@
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <chrono>
+#include <utility>
+#include <cstdlib>
+#include <type_traits>
+#include <assert.h>
+
+#include "demo_support.h"
+#include "string_concat.h"
+
+// Sum<Matrix, Matrix> for strings
+//
+// The proxy technique from use_explicitly_typed_initializer01.cpp applied to
+// std::string: concat (string_concat.h) collects the operands of a chain of +
+// and builds the result with one allocation. We compare it with plain
+// std::string operator+ on two typical workloads, building cache keys
+// ("user:" + id + ':' + field) and file paths (root + '/' + dir + '/' + name +
+// ".json").
+//
+// Note how the result is obtained: with the explicitly typed initializer idiom,
+//
+//    auto key = static_cast<std::string>(concat("user:") + id + ':' + field);
+//
+// exactly as the Item recommends for Matrix sums.
+
+template<typename T, typename = void>
+struct usable : std::false_type {};
+
+template<typename T>
+struct usable<T, decltype(void(std::declval<T>().str()))> : std::true_type {};
+
+int main(const int argc, const char* argv[])
+{
+   {
+      std::string id = "12345";
+      std::string_view field = "last_login";
+      auto key = static_cast<std::string>(concat("user:") + id + ':' + field);
+      assert(key == "user:12345:last_login");
+
+      auto path = concat(std::string("/var/data"), '/', "widgets", '/', id, ".json").str();
+      assert(path == "/var/data/widgets/12345.json");
+
+      std::string out = "prefix-";
+      (concat(id) + "-" + id).appendTo(out);
+      assert(out == "prefix-12345-12345");
+
+      // an empty view has no data, which must not be taken for a char
+      const std::string empty = (concat("ab") + std::string_view{} + "cd").str();
+      assert(empty.size() == 4 && empty == "abcd");
+
+      // a proxy in a named variable cannot be materialized or extended
+      static_assert(!usable<string_concat<2>&>::value, "lvalue proxies are unusable");
+      static_assert(usable<string_concat<2>&&>::value, "");
+      static_assert(!std::is_convertible<string_concat<2>, std::string>::value,
+                    "materialization is explicit");
+   }
+
+   const std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2000000;
+   std::vector<std::string> ids(1000), fields = { "last_login", "display_name", "avatar_url" };
+   for (std::size_t i = 0; i < ids.size(); ++i)
+      ids[i] = std::to_string(1000000 + i * 7919);
+   const std::string root = "/var/lib/effective-modern/widgets";
+
+   std::size_t a = 0, b = 0, c = 0, d = 0;
+   double plusKeyMs = timeIt([&] {
+      for (std::size_t i = 0; i < n; ++i) {
+         std::string key = "user:" + ids[i % ids.size()] + ':' + fields[i % 3];
+         a += key.size();
+      }
+   });
+   double concatKeyMs = timeIt([&] {
+      for (std::size_t i = 0; i < n; ++i) {
+         auto key = static_cast<std::string>(concat("user:") + ids[i % ids.size()] + ':' +
+                                             fields[i % 3]);
+         b += key.size();
+      }
+   });
+   double plusPathMs = timeIt([&] {
+      for (std::size_t i = 0; i < n; ++i) {
+         std::string path = root + '/' + fields[i % 3] + '/' + ids[i % ids.size()] + ".json";
+         c += path.size();
+      }
+   });
+   double concatPathMs = timeIt([&] {
+      for (std::size_t i = 0; i < n; ++i) {
+         auto path = static_cast<std::string>(concat(root) + '/' + fields[i % 3] + '/' +
+                                              ids[i % ids.size()] + ".json");
+         d += path.size();
+      }
+   });
+   assert(a == b && c == d);
+
+   std::cout << n << " strings each" << std::endl;
+   std::cout << "keys:  operator+ " << plusKeyMs << " ms, concat " << concatKeyMs << " ms"
+             << std::endl;
+   std::cout << "paths: operator+ " << plusPathMs << " ms, concat " << concatPathMs << " ms"
+             << std::endl;
+
+   return 0;
+}
@@ -0,0 +1,235 @@
+#ifndef BATCH_LOOKUP_H
+#define BATCH_LOOKUP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "cpu_dispatch.h"
+
+// Looking up many keys at once
+//
+// A single binary search is a chain of dependent loads: the address of each
+// probe depends on the outcome of the previous one, so a search over a large
+// array waits for about log2(n) cache misses one after the other, and the CPU's
+// ability to have ten or more misses in flight goes unused.
+//
+// When thousands of keys are looked up together nothing forces us to finish
+// one search before starting the next. batchLowerBound runs a group of
+// batchGroup searches in lockstep. All of them use the same branchless step
+//
+//    base = (base[half] < key) ? base + half : base;    // a conditional move
+//
+// and because the searched array is the same, all lanes halve the same length
+// at the same time. Before doing a step for every lane we prefetch the two
+// locations each lane may probe next, so the misses of the whole group overlap.
+//
+// With AVX2 and 32-bit keys the steps of eight lanes are done by one gather,
+// one compare and one masked add (batchLowerBoundAvx2); with AVX-512 sixteen
+// lanes take one, and four such vectors run interleaved (batchLowerBoundAvx512).
+// All variants return, for every query, the index of the first key not less
+// than it, i.e. the same result as std::lower_bound, so a parallel array such
+// as mappedVals can be indexed with it directly. batchLowerBound32 calls the best one the CPU
+// supports (cpu_dispatch.h).
+
+constexpr std::size_t batchGroup = 16;
+
+namespace batch_lookup_detail {
+
+inline void prefetch(const void* p) noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+   __builtin_prefetch(p);
+#else
+   (void)p;
+#endif
+}
+
+template<typename T>
+void lowerBoundGroup(const T* keys, std::size_t n,
+                     const T* queries, std::size_t count, std::size_t* out) noexcept
+{
+   const T* base[batchGroup];
+   for (std::size_t g = 0; g < count; ++g)
+      base[g] = keys;
+
+   std::size_t len = n;
+   while (len > 1) {
+      const std::size_t half = len / 2;
+      for (std::size_t g = 0; g < count; ++g) {
+         prefetch(base[g] + half / 2);
+         prefetch(base[g] + half + half / 2);
+      }
+      for (std::size_t g = 0; g < count; ++g)
+         base[g] = (base[g][half] < queries[g]) ? base[g] + half : base[g];
+      len -= half;
+   }
+   for (std::size_t g = 0; g < count; ++g)
+      out[g] = static_cast<std::size_t>(base[g] - keys) + (*base[g] < queries[g]);
+}
+
+} // namespace batch_lookup_detail
+
+// out[i] = std::lower_bound(keys, keys + n, queries[i]) - keys, for i in [0, m)
+template<typename T>
+void batchLowerBound(const T* keys, std::size_t n,
+                     const T* queries, std::size_t m, std::size_t* out) noexcept
+{
+   if (n == 0) {
+      for (std::size_t i = 0; i < m; ++i) out[i] = 0;
+      return;
+   }
+   for (std::size_t i = 0; i < m; i += batchGroup) {
+      const std::size_t count = m - i < batchGroup ? m - i : batchGroup;
+      batch_lookup_detail::lowerBoundGroup(keys, n, queries + i, count, out + i);
+   }
+}
+
+// out[i] = values[j] where keys[j] == queries[i], or notFound
+template<typename K, typename V>
+void batchLookup(const K* keys, const V* values, std::size_t n,
+                 const K* queries, std::size_t m, V* out, V notFound)
+{
+   std::size_t pos[batchGroup];
+   for (std::size_t i = 0; i < m; i += batchGroup) {
+      const std::size_t count = m - i < batchGroup ? m - i : batchGroup;
+      batchLowerBound(keys, n, queries + i, count, pos);
+      for (std::size_t g = 0; g < count; ++g) {
+         const bool hit = pos[g] < n && keys[pos[g]] == queries[i + g];
+         out[i + g] = hit ? values[pos[g]] : notFound;
+      }
+   }
+}
+
+#if CPU_DISPATCH_X86
+
+// AVX2 variant for 32-bit keys. Eight searches share one gather per step, and
+// batchGroup / 8 such vectors are interleaved. The gather takes 32-bit signed
+// indices, so with n of 2^31 or more every query goes to batchLowerBound.
+template<typename T>
+CPU_DISPATCH_AVX2 void batchLowerBoundAvx2(const T* keys, std::size_t n,
+                         const T* queries, std::size_t m, std::size_t* out) noexcept
+{
+   static_assert(sizeof(T) == 4 && std::is_integral<T>::value,
+                 "batchLowerBoundAvx2 handles 32-bit integer keys");
+   constexpr int vectors = batchGroup / 8;
+   // signed compare of unsigned keys: flip the sign bit of both sides
+   const __m256i flip = _mm256_set1_epi32(std::is_signed<T>::value ? 0 : INT32_MIN);
+   const int* k = reinterpret_cast<const int*>(keys);
+
+   std::size_t i = 0;
+   if (n > 0 && n <= std::size_t(INT32_MAX)) {
+      for (; i + batchGroup <= m; i += batchGroup) {
+         __m256i base[vectors], q[vectors];
+         for (int v = 0; v < vectors; ++v) {
+            base[v] = _mm256_setzero_si256();
+            q[v] = _mm256_xor_si256(
+               _mm256_loadu_si256(reinterpret_cast<const __m256i*>(queries + i + 8 * v)), flip);
+         }
+         std::size_t len = n;
+         while (len > 1) {
+            const int half = static_cast<int>(len / 2);
+            const __m256i vhalf = _mm256_set1_epi32(half);
+            for (int v = 0; v < vectors; ++v) {
+               const __m256i probe = _mm256_add_epi32(base[v], vhalf);
+               const __m256i key = _mm256_xor_si256(_mm256_i32gather_epi32(k, probe, 4), flip);
+               const __m256i less = _mm256_cmpgt_epi32(q[v], key);      // key < query
+               base[v] = _mm256_add_epi32(base[v], _mm256_and_si256(less, vhalf));
+            }
+            len -= half;
+         }
+         for (int v = 0; v < vectors; ++v) {
+            const __m256i key = _mm256_xor_si256(_mm256_i32gather_epi32(k, base[v], 4), flip);
+            const __m256i less = _mm256_cmpgt_epi32(q[v], key);
+            const __m256i pos = _mm256_sub_epi32(base[v], less);         // less is -1
+            alignas(32) std::int32_t lanes[8];
+            _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), pos);
+            for (int l = 0; l < 8; ++l)
+               out[i + 8 * v + l] = static_cast<std::size_t>(lanes[l]);
+         }
+      }
+   }
+   batchLowerBound(keys, n, queries + i, m - i, out + i);
+}
+
+namespace batch_lookup_detail {
+
+// k[index] for all sixteen lanes; the masked form, because GCC 12 warns about
+// the undefined source operand of the plain one
+CPU_DISPATCH_AVX512 inline __m512i gather16(const int* k, __m512i index) noexcept
+{
+   return _mm512_mask_i32gather_epi32(index, __mmask16(0xffff), index, k, 4);
+}
+
+} // namespace batch_lookup_detail
+
+// AVX-512 variant for 32-bit keys. Sixteen searches share one gather per
+// step, and avx512Vectors such vectors are interleaved. A gather has a long
+// latency, and a single dependent chain of them made an earlier one-vector
+// version slower than the AVX2 one. Like that one it leaves n of 2^31 or more
+// to batchLowerBound.
+constexpr int avx512Vectors = 4;
+
+template<typename T>
+CPU_DISPATCH_AVX512 void batchLowerBoundAvx512(const T* keys, std::size_t n,
+                                               const T* queries, std::size_t m,
+                                               std::size_t* out) noexcept
+{
+   static_assert(sizeof(T) == 4 && std::is_integral<T>::value,
+                 "batchLowerBoundAvx512 handles 32-bit integer keys");
+   constexpr int vectors = avx512Vectors;
+   constexpr std::size_t group = 16 * vectors;
+   const __m512i flip = _mm512_set1_epi32(std::is_signed<T>::value ? 0 : INT32_MIN);
+   const int* k = reinterpret_cast<const int*>(keys);
+
+   std::size_t i = 0;
+   if (n > 0 && n <= std::size_t(INT32_MAX)) {
+      for (; i + group <= m; i += group) {
+         __m512i base[vectors], q[vectors];
+         for (int v = 0; v < vectors; ++v) {
+            base[v] = _mm512_setzero_si512();
+            q[v] = _mm512_xor_si512(_mm512_loadu_si512(queries + i + 16 * v), flip);
+         }
+         std::size_t len = n;
+         while (len > 1) {
+            const int half = static_cast<int>(len / 2);
+            const __m512i vhalf = _mm512_set1_epi32(half);
+            for (int v = 0; v < vectors; ++v) {
+               const __m512i probe = _mm512_add_epi32(base[v], vhalf);
+               const __m512i key =
+                  _mm512_xor_si512(batch_lookup_detail::gather16(k, probe), flip);
+               base[v] = _mm512_mask_add_epi32(base[v], _mm512_cmpgt_epi32_mask(q[v], key),
+                                               base[v], vhalf);
+            }
+            len -= half;
+         }
+         for (int v = 0; v < vectors; ++v) {
+            const __m512i key = _mm512_xor_si512(batch_lookup_detail::gather16(k, base[v]), flip);
+            const __m512i pos = _mm512_mask_add_epi32(base[v], _mm512_cmpgt_epi32_mask(q[v], key),
+                                                      base[v], _mm512_set1_epi32(1));
+            alignas(64) std::int32_t lanes[16];
+            _mm512_store_si512(lanes, pos);
+            for (int l = 0; l < 16; ++l)
+               out[i + 16 * v + l] = static_cast<std::size_t>(lanes[l]);
+         }
+      }
+   }
+   batchLowerBound(keys, n, queries + i, m - i, out + i);
+}
+
+#endif
+
+// batchLowerBound for 32-bit unsigned keys with the best variant of this CPU;
+// any n is fine, the SIMD variants search arrays of 2^31 keys or more with the
+// scalar code
+inline cpu_dispatch::dispatched<void(const std::uint32_t*, std::size_t,
+                                     const std::uint32_t*, std::size_t, std::size_t*)>
+   batchLowerBound32{ "batchLowerBound32", {
+      { cpu_dispatch::cpu_level::scalar, &batchLowerBound<std::uint32_t> },
+#if CPU_DISPATCH_X86
+      { cpu_dispatch::cpu_level::avx2, &batchLowerBoundAvx2<std::uint32_t> },
+      { cpu_dispatch::cpu_level::avx512, &batchLowerBoundAvx512<std::uint32_t> },
+#endif
+   } };
+
+#endif // BATCH_LOOKUP_H
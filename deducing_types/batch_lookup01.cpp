@@ -0,0 +1,87 @@
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <utility>
+#include <cstdint>
+#include <cstdlib>
+#include <assert.h>
+
+#include "batch_lookup.h"
+#include "demo_support.h"
+
+// A million lookups against keyVals/mappedVals
+//
+// template_type_deduction02.cpp keeps keys and values in two parallel arrays,
+// keyVals sorted and mappedVals indexed like it. Looking up one key is a
+// std::lower_bound; looking up a million keys as a million independent
+// lower_bound calls leaves the memory system idle most of the time, because each
+// search waits for its own misses. batchLookup (batch_lookup.h) interleaves
+// groups of searches so their misses overlap.
+//
+// The AVX2 and AVX-512 variants are compiled into every x86 build and measured
+// when the CPU supports them; EMC_CPU=avx2 or EMC_CPU=scalar leaves out the
+// higher ones (cpu_dispatch.h).
+
+int keyVals[] = { 1, 3, 7, 9, 11, 22, 35 };
+int mappedVals[arraySize(keyVals)] = { 10, 30, 70, 90, 110, 220, 350 };
+
+int main(const int argc, const char* argv[])
+{
+   {
+      const int queries[] = { 0, 1, 2, 9, 22, 34, 35, 36, 11, 3, 7, 8, 1, 1, 35, 100, 9 };
+      int found[arraySize(queries)];
+      batchLookup(keyVals, mappedVals, arraySize(keyVals), queries, arraySize(queries),
+                  found, -1);
+      for (std::size_t i = 0; i < arraySize(queries); ++i) {
+         const int* it = std::lower_bound(keyVals, keyVals + arraySize(keyVals), queries[i]);
+         const bool hit = it != keyVals + arraySize(keyVals) && *it == queries[i];
+         assert(found[i] == (hit ? mappedVals[it - keyVals] : -1));
+         (void)hit;
+      }
+   }
+
+   const std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : (1u << 24);
+   const std::size_t m = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1000000;
+
+   std::vector<std::uint32_t> keys(n);
+   for (std::size_t i = 0; i < n; ++i)
+      keys[i] = static_cast<std::uint32_t>(2 * i + 1);
+   std::vector<std::uint32_t> queries(m);
+   std::uint64_t state = 88172645463325252ULL;
+   for (auto& q : queries) {
+      state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+      q = static_cast<std::uint32_t>(state % (2 * n + 2));
+   }
+
+   std::vector<std::size_t> scalar(m), batched(m);
+   double scalarMs = timeIt([&] {
+      for (std::size_t i = 0; i < m; ++i)
+         scalar[i] = std::lower_bound(keys.begin(), keys.end(), queries[i]) - keys.begin();
+   });
+   double batchedMs = timeIt([&] {
+      batchLowerBound(keys.data(), n, queries.data(), m, batched.data());
+   });
+   assert(scalar == batched);
+
+   std::cout << m << " lookups in " << n << " keys" << std::endl;
+   std::cout << "std::lower_bound each:     " << scalarMs << " ms" << std::endl;
+   std::cout << "batchLowerBound:           " << batchedMs << " ms" << std::endl;
+
+   const struct { cpu_dispatch::cpu_level level; const char* label; } variants[] = {
+      { cpu_dispatch::cpu_level::avx2, "batchLowerBoundAvx2:       " },
+      { cpu_dispatch::cpu_level::avx512, "batchLowerBoundAvx512:     " },
+   };
+   for (const auto& v : variants) {
+      if (v.level > cpu_dispatch::selectedLevel())
+         continue;
+      std::vector<std::size_t> gathered(m);
+      double gatheredMs = timeIt([&] {
+         batchLowerBound32.at(v.level)(keys.data(), n, queries.data(), m, gathered.data());
+      });
+      assert(scalar == gathered);
+      std::cout << v.label << gatheredMs << " ms" << std::endl;
+   }
+
+   return 0;
+}
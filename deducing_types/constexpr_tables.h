@@ -0,0 +1,138 @@
+#ifndef CONSTEXPR_TABLES_H
+#define CONSTEXPR_TABLES_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+
+// Building lookup tables during compilation (C++17)
+//
+// template_type_deduction02.cpp shows that arraySize makes the length of an
+// array a compile-time constant. The same is true of the contents of a
+// constexpr array, and with C++17's constexpr std::array any table derived from
+// such arrays (inverse maps, prefix sums, CRC tables, bit reversal tables) can
+// be computed by the compiler instead of by an initialization function at
+// startup:
+//
+//    constexpr auto crc = crc32Table();   // 256 entries in .rodata
+//
+// Each builder returns a std::array whose size is fixed by its template
+// arguments or by the size of the source array, so arraySize (extended below
+// to std::array) can be used in static_asserts to tie tables to their sources.
+// It lives in namespace constexpr_tables, since many sources that may include
+// this header define their own global arraySize.
+// A table must be stored in a constexpr variable to be guaranteed to be built
+// at compile time; errors in the source data (an inverse map of a value out of
+// range, a duplicate value) then become compile errors.
+
+namespace constexpr_tables {
+
+template<typename T, std::size_t N>
+constexpr std::size_t arraySize(T (&)[N]) noexcept
+{
+   return N;
+}
+
+template<typename T, std::size_t N>
+constexpr std::size_t arraySize(const std::array<T, N>&) noexcept
+{
+   return N;
+}
+
+} // namespace constexpr_tables
+
+// table[i] = gen(i) for i in [0, N)
+template<std::size_t N, typename Gen>
+constexpr auto generateTable(Gen gen)
+{
+   std::array<std::decay_t<decltype(gen(std::size_t()))>, N> table{};
+   for (std::size_t i = 0; i < N; ++i)
+      table[i] = gen(i);
+   return table;
+}
+
+// table[i] = f(src[i])
+template<typename T, std::size_t N, typename F>
+constexpr auto transformTable(const T (&src)[N], F f)
+{
+   return generateTable<N>([&](std::size_t i) { return f(src[i]); });
+}
+
+template<typename T, std::size_t N, typename F>
+constexpr auto transformTable(const std::array<T, N>& src, F f)
+{
+   return generateTable<N>([&](std::size_t i) { return f(src[i]); });
+}
+
+// exclusive prefix sums: table[i] is the sum of src[0..i), table[N] the total
+template<typename T, std::size_t N>
+constexpr std::array<T, N + 1> prefixSumTable(const T (&src)[N])
+{
+   std::array<T, N + 1> table{};
+   for (std::size_t i = 0; i < N; ++i)
+      table[i + 1] = table[i] + src[i];
+   return table;
+}
+
+// inverse of a map from index to value: table[src[i]] = i, and missing for
+// every value in [0, Size) that does not occur in src
+template<std::size_t Size, typename T, std::size_t N>
+constexpr std::array<int, Size> inverseTable(const T (&src)[N], int missing = -1)
+{
+   std::array<int, Size> table{};
+   for (std::size_t v = 0; v < Size; ++v)
+      table[v] = missing;
+   for (std::size_t i = 0; i < N; ++i) {
+      if constexpr (std::is_signed<T>::value) {
+         if (src[i] < 0)
+            throw std::out_of_range("inverseTable: value outside [0, Size)");
+      }
+      if (static_cast<std::size_t>(src[i]) >= Size)
+         throw std::out_of_range("inverseTable: value outside [0, Size)");
+      if (table[src[i]] != missing)
+         throw std::logic_error("inverseTable: duplicate value");
+      table[src[i]] = static_cast<int>(i);
+   }
+   return table;
+}
+
+// the byte-wise CRC-32 table for a reflected polynomial (the zlib/PNG CRC by
+// default)
+constexpr std::array<std::uint32_t, 256> crc32Table(std::uint32_t poly = 0xEDB88320u)
+{
+   std::array<std::uint32_t, 256> table{};
+   for (std::uint32_t byte = 0; byte < 256; ++byte) {
+      std::uint32_t crc = byte;
+      for (int bit = 0; bit < 8; ++bit)
+         crc = (crc >> 1) ^ ((crc & 1u) ? poly : 0u);
+      table[byte] = crc;
+   }
+   return table;
+}
+
+// CRC-32 of data[0, length) using a table made by crc32Table
+constexpr std::uint32_t crc32(const std::array<std::uint32_t, 256>& table,
+                              const char* data, std::size_t length)
+{
+   std::uint32_t crc = 0xFFFFFFFFu;
+   for (std::size_t i = 0; i < length; ++i)
+      crc = table[(crc ^ static_cast<unsigned char>(data[i])) & 0xFFu] ^ (crc >> 8);
+   return crc ^ 0xFFFFFFFFu;
+}
+
+// table[i] is i with its lowest Bits bits in reverse order
+template<unsigned Bits>
+constexpr std::array<std::uint32_t, (std::size_t(1) << Bits)> bitReversalTable()
+{
+   static_assert(Bits >= 1 && Bits <= 24, "bitReversalTable: 1 to 24 bits");
+   return generateTable<(std::size_t(1) << Bits)>([](std::size_t i) {
+      std::uint32_t r = 0;
+      for (unsigned b = 0; b < Bits; ++b)
+         r |= static_cast<std::uint32_t>((i >> b) & 1u) << (Bits - 1 - b);
+      return r;
+   });
+}
+
+#endif // CONSTEXPR_TABLES_H
@@ -0,0 +1,65 @@
+#include <iostream>
+#include <array>
+#include <string>
+#include <cstdint>
+#include <assert.h>
+
+#include "constexpr_tables.h"
+
+using constexpr_tables::arraySize;
+
+// Tables derived from arrays, built by the compiler
+//
+// In template_type_deduction02.cpp keyVals and mappedVals are sized by
+// arraySize, but anything derived from them would still be filled in at run
+// time. Here keyVals is constexpr and every derived table is a constexpr
+// variable built with constexpr_tables.h. The static_asserts are evaluated by
+// the compiler: if this file compiles, the tables are correct, and the program
+// starts with all of them already sitting in read-only data.
+
+constexpr int keyVals[] = { 1, 3, 7, 9, 11, 22, 35 };   // keyVals has 7 elements
+
+// mappedVals: computed from keyVals instead of filled in by hand
+constexpr auto mappedVals = transformTable(keyVals, [](int k) { return k * 10; });
+static_assert(arraySize(mappedVals) == arraySize(keyVals), "one value per key");
+static_assert(mappedVals[3] == 90, "");
+
+// inverse map: key -> position in keyVals, -1 for values that are not keys
+constexpr auto keyPosition = inverseTable<36>(keyVals);
+static_assert(keyPosition[22] == 5 && keyPosition[2] == -1, "");
+
+// unsigned values skip the check for negatives
+constexpr unsigned opcodes[] = { 4, 0, 2 };
+constexpr auto opcodePosition = inverseTable<5>(opcodes);
+static_assert(opcodePosition[2] == 2 && opcodePosition[1] == -1, "");
+
+// prefix sums: the sum of any slice of keyVals in two loads
+constexpr auto keyPrefix = prefixSumTable(keyVals);
+static_assert(arraySize(keyPrefix) == arraySize(keyVals) + 1, "");
+static_assert(keyPrefix[arraySize(keyVals)] == 88, "");
+static_assert(keyPrefix[5] - keyPrefix[2] == 7 + 9 + 11, "");
+
+constexpr auto crcTable = crc32Table();
+static_assert(crc32(crcTable, "123456789", 9) == 0xCBF43926u, "CRC-32 check value");
+
+constexpr auto reverse8 = bitReversalTable<8>();
+static_assert(reverse8[0x01] == 0x80 && reverse8[0xF0] == 0x0F, "");
+
+// a generator can be anything constexpr: squares, say
+constexpr auto squares = generateTable<16>([](std::size_t i) { return i * i; });
+static_assert(squares[15] == 225, "");
+
+int main(const int argc, const char* argv[])
+{
+   for (std::size_t i = 0; i < arraySize(keyVals); ++i) {
+      assert(mappedVals[i] == keyVals[i] * 10);
+      assert(keyPosition[keyVals[i]] == static_cast<int>(i));
+   }
+
+   // the same tables serve run-time data
+   const std::string message = argc > 1 ? argv[1] : "Effective Modern C++";
+   std::cout << "crc32(\"" << message << "\") = " << std::hex
+             << crc32(crcTable, message.data(), message.size()) << std::dec << std::endl;
+
+   return 0;
+}
@@ -0,0 +1,263 @@
+#ifndef CPU_DISPATCH_H
+#define CPU_DISPATCH_H
+
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define CPU_DISPATCH_X86 1
+#include <cpuid.h>
+#include <immintrin.h>
+#else
+#define CPU_DISPATCH_X86 0
+#endif
+
+// Picking a SIMD kernel once, at run time
+//
+// auto_type_deduction01.cpp shows a function decaying to a pointer:
+//
+//    auto func1 = someFunc;   // void (*)(int, double)
+//
+// That pointer is all it takes to ship one binary that uses AVX-512 where the
+// CPU has it and still runs on one that does not. Each variant of a kernel is
+// compiled for its own instruction set with a target attribute (the rest of
+// the program is built for the baseline), the CPU is asked once through CPUID
+// what it supports, and the best variant is stored in a function pointer.
+// Every call afterwards is one indirect call; no feature is tested per call,
+// and the branch predictor learns the target after the first one.
+//
+//    CPU_DISPATCH_AVX2 void sumAvx2(const int* p, std::size_t n, long* out);
+//    void sumScalar(const int* p, std::size_t n, long* out);
+//
+//    inline cpu_dispatch::dispatched<void(const int*, std::size_t, long*)> sum{
+//       "sum", { { cpu_dispatch::cpu_level::scalar, &sumScalar },
+//                { cpu_dispatch::cpu_level::avx2, &sumAvx2 } } };
+//
+//    sum(p, n, &total);            // sumAvx2 on an AVX2 machine
+//
+// The levels follow the x86-64 micro-architecture levels: sse42 is SSE4.2 and
+// POPCNT (v2), avx2 adds AVX, AVX2, FMA, BMI1 and BMI2 (v3), avx512 adds
+// AVX-512 F, BW, DQ and VL (v4). AVX levels also need the operating system to
+// save the wider registers, which CPUID reports through XGETBV. A kernel
+// registers the levels it has, always including scalar, and gets the highest
+// one that does not exceed the selected level.
+//
+// The environment variable EMC_CPU (scalar, sse4.2, avx2 or avx512) lowers the
+// selected level, to test or benchmark each variant on one machine; a level
+// the CPU lacks is never selected. forceLevel does the same from code and
+// reselects every registered kernel; it must not race with calls to them.
+//
+// The variables are resolved during static initialization, so a kernel must
+// not be called from the static initializer of another translation unit.
+
+namespace cpu_dispatch {
+
+enum class cpu_level { scalar, sse42, avx2, avx512 };
+
+inline const char* levelName(cpu_level level) noexcept
+{
+   switch (level) {
+   case cpu_level::sse42: return "sse4.2";
+   case cpu_level::avx2: return "avx2";
+   case cpu_level::avx512: return "avx512";
+   default: return "scalar";
+   }
+}
+
+// compiles one function for a level above the program's baseline
+#if CPU_DISPATCH_X86
+#define CPU_DISPATCH_SSE42 __attribute__((target("sse4.2,popcnt")))
+#define CPU_DISPATCH_AVX2 __attribute__((target("avx2,fma,bmi,bmi2")))
+#define CPU_DISPATCH_AVX512 \
+   __attribute__((target("avx512f,avx512bw,avx512dq,avx512vl,avx2,fma,bmi,bmi2")))
+#endif
+
+namespace cpu_dispatch_detail {
+
+#if CPU_DISPATCH_X86
+inline unsigned long long xgetbv() noexcept
+{
+   unsigned lo, hi;
+   __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+   return (static_cast<unsigned long long>(hi) << 32) | lo;
+}
+#endif
+
+inline cpu_level detect() noexcept
+{
+#if CPU_DISPATCH_X86
+   unsigned a, b, c, d;
+   if (!__get_cpuid(1, &a, &b, &c, &d) || !(c & bit_SSE4_2) || !(c & bit_POPCNT))
+      return cpu_level::scalar;
+   const unsigned avx = bit_OSXSAVE | bit_AVX | bit_FMA;
+   if ((c & avx) != avx)
+      return cpu_level::sse42;
+   const unsigned long long xcr0 = xgetbv();
+   if ((xcr0 & 0x6) != 0x6)                    // XMM and YMM state
+      return cpu_level::sse42;
+   if (!__get_cpuid_count(7, 0, &a, &b, &c, &d))
+      return cpu_level::sse42;
+   const unsigned v3 = bit_AVX2 | bit_BMI | bit_BMI2;
+   if ((b & v3) != v3)
+      return cpu_level::sse42;
+   const unsigned v4 = bit_AVX512F | bit_AVX512BW | bit_AVX512DQ | bit_AVX512VL;
+   if ((b & v4) != v4 || (xcr0 & 0xe0) != 0xe0)   // opmask and ZMM state
+      return cpu_level::avx2;
+   return cpu_level::avx512;
+#else
+   return cpu_level::scalar;
+#endif
+}
+
+// the detected level, lowered by EMC_CPU
+inline cpu_level initialLevel()
+{
+   const cpu_level detected = detect();
+   const char* env = std::getenv("EMC_CPU");
+   if (!env || !*env)
+      return detected;
+   for (cpu_level level : { cpu_level::scalar, cpu_level::sse42, cpu_level::avx2,
+                            cpu_level::avx512 }) {
+      if (std::strcmp(env, levelName(level)) == 0)
+         return level < detected ? level : detected;
+   }
+   std::cerr << "cpu_dispatch: ignoring unknown EMC_CPU=" << env << std::endl;
+   return detected;
+}
+
+class kernel_base;
+
+struct registry {
+   cpu_level detected = detect();
+   cpu_level selected = initialLevel();
+   std::vector<kernel_base*> kernels;
+};
+
+inline registry& state()
+{
+   static registry r;
+   return r;
+}
+
+class kernel_base {
+public:
+   kernel_base(const kernel_base&) = delete;
+   kernel_base& operator=(const kernel_base&) = delete;
+
+   const char* name() const noexcept { return name_; }
+   cpu_level level() const noexcept { return level_; }
+   virtual void select(cpu_level level) noexcept = 0;
+
+protected:
+   explicit kernel_base(const char* name) : name_(name) { state().kernels.push_back(this); }
+
+   ~kernel_base()
+   {
+      auto& kernels = state().kernels;
+      for (auto it = kernels.begin(); it != kernels.end(); ++it) {
+         if (*it == this) {
+            kernels.erase(it);
+            break;
+         }
+      }
+   }
+
+   const char* name_;
+   cpu_level level_ = cpu_level::scalar;
+};
+
+} // namespace cpu_dispatch_detail
+
+// what the CPU supports, and what the kernels are selected for
+inline cpu_level detectedLevel() noexcept { return cpu_dispatch_detail::state().detected; }
+inline cpu_level selectedLevel() noexcept { return cpu_dispatch_detail::state().selected; }
+
+template<typename Signature>
+class dispatched;
+
+template<typename R, typename... Args>
+class dispatched<R(Args...)> : public cpu_dispatch_detail::kernel_base {
+public:
+   using function = R (*)(Args...);
+
+   struct variant {
+      cpu_level level;
+      function fn;
+   };
+
+   dispatched(const char* name, std::initializer_list<variant> variants)
+      : kernel_base(name), variants_(variants)
+   {
+      bool scalar = false;
+      for (const variant& v : variants_)
+         scalar = scalar || (v.level == cpu_level::scalar && v.fn);
+      if (!scalar)
+         throw std::invalid_argument(std::string("cpu_dispatch: ") + name + " has no scalar variant");
+      select(selectedLevel());
+   }
+
+   R operator()(Args... args) const { return fn_(std::forward<Args>(args)...); }
+
+   // the selected variant
+   function get() const noexcept { return fn_; }
+
+   // the best variant at or below level, to compare the variants directly
+   function at(cpu_level level) const noexcept
+   {
+      if (level > detectedLevel())
+         level = detectedLevel();
+      function best = nullptr;
+      cpu_level bestLevel = cpu_level::scalar;
+      for (const variant& v : variants_) {
+         if (v.fn && v.level <= level && (!best || v.level >= bestLevel)) {
+            best = v.fn;
+            bestLevel = v.level;
+         }
+      }
+      return best;
+   }
+
+   void select(cpu_level level) noexcept override
+   {
+      fn_ = at(level);
+      level_ = cpu_level::scalar;
+      for (const variant& v : variants_) {
+         if (v.fn == fn_ && v.level > level_)
+            level_ = v.level;
+      }
+   }
+
+private:
+   std::vector<variant> variants_;
+   function fn_ = nullptr;
+};
+
+// reselects every kernel for level (at most the detected one); returns the
+// previous level
+inline cpu_level forceLevel(cpu_level level) noexcept
+{
+   auto& s = cpu_dispatch_detail::state();
+   const cpu_level previous = s.selected;
+   s.selected = level < s.detected ? level : s.detected;
+   for (cpu_dispatch_detail::kernel_base* k : s.kernels)
+      k->select(s.selected);
+   return previous;
+}
+
+// one line per registered kernel with the variant it calls
+inline void printKernels(std::ostream& os)
+{
+   const auto& s = cpu_dispatch_detail::state();
+   os << "cpu: " << levelName(s.detected) << ", selected: " << levelName(s.selected) << std::endl;
+   for (const cpu_dispatch_detail::kernel_base* k : s.kernels)
+      os << "   " << k->name() << ": " << levelName(k->level()) << std::endl;
+}
+
+} // namespace cpu_dispatch
+
+#endif // CPU_DISPATCH_H
@@ -0,0 +1,164 @@
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <assert.h>
+
+#include "cpu_dispatch.h"
+#include "batch_lookup.h"
+#include "demo_support.h"
+
+// One binary, four instruction sets
+//
+// auto_type_deduction01.cpp: auto func1 = someFunc; gives a function pointer.
+// cpu_dispatch.h keeps one such pointer per kernel and points it at the best
+// variant for the CPU the program runs on.
+//
+// sum below is one C++ loop compiled four times, for the baseline and with the
+// target attributes for SSE4.2, AVX2 and AVX-512, so the compiler vectorizes
+// each copy for its own registers. We check that every variant the CPU
+// supports, of sum and of batchLowerBound32 (batch_lookup.h), gives the same
+// result as the scalar one, and time each. Then we compare the cost of calling
+// a short kernel through a plain function pointer, through the dispatched one,
+// and through a function that tests the CPU features on every call (against
+// flags libgcc caches, so this is the cheap kind of per-call test).
+//
+// On an AVX-512 machine all three took 180-270 ms for 20 million calls, with
+// no consistent winner: the per-call test is a few predictable branches on a
+// cached load, and costs about what the indirect call does. What the stored
+// pointer saves is writing that test into every kernel, not time. Letting the
+// compiler inline the variants into sumChecked took 120-160 ms. A short kernel
+// gains more from a direct, inlinable call than from any form of dispatch, so
+// dispatch belongs around loops, not inside them.
+//
+// Run with EMC_CPU=scalar (or sse4.2, avx2) to select a lower variant.
+
+using sum_kernel = std::uint64_t(const std::uint32_t*, std::size_t);
+
+// the variants are never inlined, so that sumChecked below pays for a call
+// like the two pointers do, and the comparison is only about the dispatch
+#if defined(__GNUC__) || defined(__clang__)
+#define SUM_NOINLINE __attribute__((noinline))
+#else
+#define SUM_NOINLINE
+#endif
+
+SUM_NOINLINE std::uint64_t sumScalar(const std::uint32_t* p, std::size_t n) noexcept
+{
+   std::uint64_t s = 0;
+   for (std::size_t i = 0; i < n; ++i) s += p[i];
+   return s;
+}
+
+#if CPU_DISPATCH_X86
+SUM_NOINLINE CPU_DISPATCH_SSE42 std::uint64_t sumSse42(const std::uint32_t* p, std::size_t n) noexcept
+{
+   std::uint64_t s = 0;
+   for (std::size_t i = 0; i < n; ++i) s += p[i];
+   return s;
+}
+
+SUM_NOINLINE CPU_DISPATCH_AVX2 std::uint64_t sumAvx2(const std::uint32_t* p, std::size_t n) noexcept
+{
+   std::uint64_t s = 0;
+   for (std::size_t i = 0; i < n; ++i) s += p[i];
+   return s;
+}
+
+SUM_NOINLINE CPU_DISPATCH_AVX512 std::uint64_t sumAvx512(const std::uint32_t* p, std::size_t n) noexcept
+{
+   std::uint64_t s = 0;
+   for (std::size_t i = 0; i < n; ++i) s += p[i];
+   return s;
+}
+
+// what dispatching without a stored pointer looks like
+std::uint64_t sumChecked(const std::uint32_t* p, std::size_t n) noexcept
+{
+   if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+       __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("avx512vl"))
+      return sumAvx512(p, n);
+   if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") &&
+       __builtin_cpu_supports("bmi2"))
+      return sumAvx2(p, n);
+   if (__builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt"))
+      return sumSse42(p, n);
+   return sumScalar(p, n);
+}
+#endif
+
+cpu_dispatch::dispatched<sum_kernel> sum{ "sum", {
+   { cpu_dispatch::cpu_level::scalar, &sumScalar },
+#if CPU_DISPATCH_X86
+   { cpu_dispatch::cpu_level::sse42, &sumSse42 },
+   { cpu_dispatch::cpu_level::avx2, &sumAvx2 },
+   { cpu_dispatch::cpu_level::avx512, &sumAvx512 },
+#endif
+} };
+
+int main(const int argc, const char* argv[])
+{
+   const std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : (1u << 22);
+   cpu_dispatch::printKernels(std::cout);
+
+   std::vector<std::uint32_t> data(n);
+   std::uint64_t state = 88172645463325252ULL;
+   for (auto& x : data) {
+      state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+      x = static_cast<std::uint32_t>(state);
+   }
+   std::vector<std::uint32_t> keys(data);
+   std::sort(keys.begin(), keys.end());
+
+   const std::uint64_t expected = sumScalar(data.data(), n);
+   (void)expected;
+   std::vector<std::size_t> expectedPos(n), pos(n);
+   batchLowerBound(keys.data(), n, data.data(), n, expectedPos.data());
+
+   // every level up to the selected one, whatever EMC_CPU says afterwards
+   const cpu_dispatch::cpu_level top = cpu_dispatch::selectedLevel();
+   for (auto level : { cpu_dispatch::cpu_level::scalar, cpu_dispatch::cpu_level::sse42,
+                       cpu_dispatch::cpu_level::avx2, cpu_dispatch::cpu_level::avx512 }) {
+      if (level > top)
+         break;
+      cpu_dispatch::forceLevel(level);
+      std::uint64_t total = 0;
+      const double sumMs = timeIt([&] {
+         for (int r = 0; r < 10; ++r) total += sum(data.data(), n);
+      });
+      const double lookupMs = timeIt([&] {
+         batchLowerBound32(keys.data(), n, data.data(), n, pos.data());
+      });
+      assert(total == 10 * expected && pos == expectedPos);
+      std::cout << cpu_dispatch::levelName(level) << ": sum of " << n << " x 10 " << sumMs
+                << " ms (" << cpu_dispatch::levelName(sum.level()) << "), " << n
+                << " lookups " << lookupMs << " ms ("
+                << cpu_dispatch::levelName(batchLowerBound32.level()) << ")" << std::endl;
+   }
+   cpu_dispatch::forceLevel(top);
+
+   // call overhead on a kernel that does almost nothing
+   const std::size_t shortN = 16;
+   const int calls = 20000000;
+   std::uint64_t sink = 0;
+   sum_kernel* direct = sum.at(top);
+   const double directMs = timeIt([&] {
+      for (int i = 0; i < calls; ++i) sink += direct(data.data() + (i & 1023), shortN);
+   });
+   const double dispatchedMs = timeIt([&] {
+      for (int i = 0; i < calls; ++i) sink += sum(data.data() + (i & 1023), shortN);
+   });
+   std::cout << calls << " calls of sum(16 elements): function pointer " << directMs
+             << " ms, dispatched " << dispatchedMs << " ms";
+#if CPU_DISPATCH_X86
+   const double checkedMs = timeIt([&] {
+      for (int i = 0; i < calls; ++i) sink += sumChecked(data.data() + (i & 1023), shortN);
+   });
+   std::cout << ", feature test per call " << checkedMs << " ms";
+#endif
+   std::cout << " (" << sink << ")" << std::endl;
+
+   return 0;
+}
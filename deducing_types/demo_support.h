@@ -0,0 +1,52 @@
+#ifndef DEMO_SUPPORT_H
+#define DEMO_SUPPORT_H
+
+#include <chrono>
+#include <cstddef>
+#include <ratio>
+#include <utility>
+
+// What the *01.cpp demos share
+//
+// Most demos time a few variants of the same work, many of them call
+// authAndAccess from understand_decltype01.cpp on their own containers, and
+// several size arrays with arraySize from template_type_deduction02.cpp. These
+// live here once, instead of in a copy per demo. understand_decltype01.cpp and
+// template_type_deduction02.cpp keep their own versions, since walking through
+// them is what those chapters are about.
+//
+// Demos in other directories add this one to their include path.
+
+// how long f() took, in milliseconds, or in Period (timeIt<std::nano>)
+template<typename Period = std::milli, typename F>
+double timeIt(F&& f)
+{
+   auto start = std::chrono::steady_clock::now();
+   std::forward<F>(f)();
+   std::chrono::duration<double, Period> elapsed =
+      std::chrono::steady_clock::now() - start;
+   return elapsed.count();
+}
+
+inline void authenticateUser() {
+ // do some authentication
+}
+
+// the C++11 authAndAccess of understand_decltype01.cpp
+template<typename Container, typename Index>
+auto
+authAndAccess(Container&& c, Index i)
+-> decltype(std::forward<Container>(c)[i])
+{
+   authenticateUser();
+   return std::forward<Container>(c)[i];
+}
+
+// the arraySize of template_type_deduction02.cpp
+template<typename T, std::size_t N>
+constexpr std::size_t arraySize(T (&)[N]) noexcept
+{
+   return N;
+}
+
+#endif // DEMO_SUPPORT_H
@@ -0,0 +1,97 @@
+#ifndef ELEMENT_ACCESS_H
+#define ELEMENT_ACCESS_H
+
+#include <type_traits>
+#include <utility>
+
+// Moving elements out of temporary containers
+//
+// authAndAccess5 from understand_decltype01.cpp returns
+// std::forward<Container>(c)[i]. For std::deque and std::vector operator[] is not
+// overloaded on value category, so even for an rvalue container it returns a T&,
+// decltype(auto) makes the return type T&, and
+//
+//    auto s = authAndAccess5(makeStringDeque(), 5);
+//
+// copy-constructs s from a reference into a container that is about to be
+// destroyed. Nobody else can observe that element any more, so it could just as
+// well be moved.
+//
+// forwardElement(c, i) does for an element what std::forward does for an object:
+//
+// * c is an lvalue: returns exactly what c[i] returns (T& for most containers,
+//   the proxy for std::vector<bool>), just like authAndAccess5
+//
+// * c is an rvalue: returns an element by value, moved out of the container:
+//   - if c[i] yields a reference, the result is move-constructed from it
+//   - if c[i] yields the container's proxy reference type (std::vector<bool>),
+//     the proxy is converted to value_type before the container dies
+//   - if c[i] yields any other object, as string_column and lazy_sequence do
+//     for rvalues, the container has already produced an owning value and it
+//     is returned as is
+//
+// Returning by value for rvalues also means that the result can never dangle.
+
+namespace element_access_detail {
+
+template<typename C, typename = void>
+struct declared_reference { using type = void; };
+
+template<typename C>
+struct declared_reference<C, decltype(void(std::declval<typename C::reference>()))> {
+   using type = typename C::reference;
+};
+
+template<typename C, typename = void>
+struct declared_value { using type = void; };
+
+template<typename C>
+struct declared_value<C, decltype(void(std::declval<typename C::value_type>()))> {
+   using type = typename C::value_type;
+};
+
+// the by-value result of indexing an rvalue container of type C with an I
+template<typename C, typename I>
+struct moved_element {
+   using indexed = decltype(std::declval<C>()[std::declval<I>()]);
+   using proxy = declared_reference<std::decay_t<C>>;
+   using value = declared_value<std::decay_t<C>>;
+
+   static constexpr bool isProxy =
+      !std::is_reference<indexed>::value &&
+      std::is_same<indexed, typename proxy::type>::value &&
+      !std::is_void<typename value::type>::value;
+
+   using type = std::conditional_t<isProxy, typename value::type, std::decay_t<indexed>>;
+};
+
+template<typename Container, typename Index>
+decltype(auto) forwardElement(Container& c, Index i, std::true_type /* lvalue */)
+{
+   return c[i];
+}
+
+template<typename Container, typename Index>
+typename moved_element<Container, Index>::type
+forwardElement(Container& c, Index i, std::false_type /* rvalue */)
+{
+   // std::move(c)[i] picks operator[] && where a container has one; a reference
+   // result is then cast to an rvalue so the element is moved, not copied
+   using indexed = typename moved_element<Container, Index>::indexed;
+   using result = typename moved_element<Container, Index>::type;
+   return static_cast<result>(
+      static_cast<std::conditional_t<std::is_reference<indexed>::value,
+                                     std::remove_reference_t<indexed>&&,
+                                     indexed>>(std::move(c)[i]));
+}
+
+} // namespace element_access_detail
+
+template<typename Container, typename Index>
+decltype(auto) forwardElement(Container&& c, Index i)
+{
+   return element_access_detail::forwardElement<std::remove_reference_t<Container>>(
+             c, i, std::is_lvalue_reference<Container>());
+}
+
+#endif // ELEMENT_ACCESS_H
@@ -0,0 +1,150 @@
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <deque>
+#include <vector>
+#include <utility>
+#include <type_traits>
+#include <assert.h>
+
+#include "demo_support.h"
+#include "element_access.h"
+#include "lazy_generator.h"
+#include "string_column.h"
+
+// Moving an element out of a temporary container
+//
+// The last authAndAccess of understand_decltype01.cpp forwards the container, but
+// std::deque<std::string>::operator[] has no rvalue overload, so
+//
+//    auto s = authAndAccess5(makeStringDeque(), 5);
+//
+// still copies the string out of the dying deque. authAndAccess6 below uses
+// forwardElement (element_access.h) instead of indexing directly. For lvalue
+// containers nothing changes; for rvalue containers the element is moved out and
+// returned by value.
+//
+// To check that no copies happen we store a small string wrapper that counts
+// how often it is copied and moved.
+
+template<typename Container, typename Index>  // final C++14 version
+decltype(auto)
+authAndAccess5(Container&& c, Index i)
+{
+  authenticateUser();
+  return std::forward<Container>(c)[i];
+}
+
+template<typename Container, typename Index>  // moves out of rvalue containers
+decltype(auto)
+authAndAccess6(Container&& c, Index i)
+{
+  authenticateUser();
+  return forwardElement(std::forward<Container>(c), i);
+}
+
+struct CountedString {
+   static int copies;
+   static int moves;
+
+   std::string s;
+
+   CountedString(std::string str) : s(std::move(str)) {}
+   CountedString(const CountedString& other) : s(other.s) { ++copies; }
+   CountedString(CountedString&& other) noexcept : s(std::move(other.s)) { ++moves; }
+   CountedString& operator=(const CountedString& other) { s = other.s; ++copies; return *this; }
+   CountedString& operator=(CountedString&& other) noexcept
+   { s = std::move(other.s); ++moves; return *this; }
+};
+
+int CountedString::copies = 0;
+int CountedString::moves = 0;
+
+template<typename Container>
+Container makeCountedStrings() {
+   Container res;
+   for (int i = 1; i < 10; ++i)
+      res.emplace_back(std::string(32, static_cast<char>('0' + i)));  // beyond SSO
+   CountedString::copies = 0;
+   CountedString::moves = 0;
+   return res;
+}
+
+const char* lastBuffer = nullptr;
+
+std::deque<std::string> makeStringDeque() {
+   std::deque<std::string> res;
+   for (int i = 1; i < 10; ++i)
+      res.push_back(std::string(32, static_cast<char>('0' + i)));
+   lastBuffer = res[5].data();
+   return res;
+}
+
+template<typename Container>
+void checkNoCopies()
+{
+   auto s = authAndAccess6(makeCountedStrings<Container>(), 5);
+   static_assert(std::is_same<decltype(s), CountedString>::value, "");
+   assert(s.s == std::string(32, '6'));
+   assert(CountedString::copies == 0);
+
+   // compare with authAndAccess5, which copies
+   auto t = authAndAccess5(makeCountedStrings<Container>(), 5);
+   assert(t.s == s.s);
+   assert(CountedString::copies == 1);
+}
+
+int main()
+{
+   checkNoCopies<std::deque<CountedString>>();
+   checkNoCopies<std::vector<CountedString>>();
+
+   // the heap buffer of a long string travels out of the temporary deque
+   {
+      std::string s = authAndAccess6(makeStringDeque(), 5);
+      assert(s.data() == lastBuffer);
+   }
+
+   // lvalue containers still hand out references
+   {
+      std::deque<std::string> d = makeStringDeque();
+      static_assert(std::is_same<decltype(authAndAccess6(d, 5)), std::string&>::value, "");
+      authAndAccess6(d, 5) = "changed";
+      assert(d[5] == "changed");
+
+      const std::vector<int> cv = { 1, 2, 3 };
+      static_assert(std::is_same<decltype(authAndAccess6(cv, 1)), const int&>::value, "");
+   }
+
+   // std::vector<bool>: the proxy is resolved before the temporary goes away
+   {
+      auto bit = authAndAccess6(std::vector<bool>{ true, false, true }, 2);
+      static_assert(std::is_same<decltype(bit), bool>::value, "");
+      assert(bit);
+
+      std::vector<bool> bits = { false, false };
+      authAndAccess6(bits, 1) = true;
+      assert(bits[1]);
+   }
+
+   // our own containers produce owning values for rvalues themselves
+   {
+      string_column col;
+      col.push_back("Mieko");
+      col.push_back("Hanna");
+      static_assert(std::is_same<decltype(authAndAccess6(col, 1)), std::string_view>::value, "");
+
+      auto s = authAndAccess6(std::move(col), 1);
+      static_assert(std::is_same<decltype(s), std::string>::value, "");
+      assert(s == "Hanna");
+
+      auto seq = makeLazySequence(9, [](std::size_t i) { return std::to_string(i + 1); });
+      auto e = authAndAccess6(seq, 5);
+      static_assert(std::is_same<decltype(e), std::string>::value, "");
+      assert(e == "6");
+   }
+
+   std::cout << "authAndAccess6 on temporary containers: 0 string copies" << std::endl;
+
+   return 0;
+}
@@ -0,0 +1,175 @@
+#ifndef EYTZINGER_SEARCH_H
+#define EYTZINGER_SEARCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+// Eytzinger layout for searching sorted arrays
+//
+// std::lower_bound over a sorted array of millions of keys is cache hostile:
+// the first probes are spread over the whole array, so each of the top ~20
+// levels of the implicit search tree costs a cache miss, and the direction of
+// every step is a 50/50 branch the predictor cannot learn.
+//
+// eytzinger_index copies the keys into the order of a breadth first walk of
+// that search tree (the layout Eytzinger used for genealogies): the root at
+// position 1, and the children of position k at 2k and 2k+1. The hot top of the
+// tree is now packed into a few cache lines, and the descent
+//
+//    k = 2 * k + (keys[k] < x);
+//
+// has no branch at all. Since the 16 descendants four levels below k are
+// consecutive (positions 16k .. 16k+15), they share one or two cache lines
+// and can be prefetched while the current levels are being compared. The
+// array is aligned to a cache line so that those descendants mostly share one.
+//
+// When the descent falls off the tree, the bits of k record the turns taken;
+// stripping the trailing right turns plus one left turn leaves the position of
+// the lower bound. Next to each key we keep its index in the original array, so
+// the result can be used directly with a parallel array such as mappedVals.
+//
+// Index is the type of those stored indices; std::uint32_t halves the memory
+// compared with std::size_t and is enough up to 4G keys.
+
+template<typename T, typename Index = std::uint32_t>
+class eytzinger_index {
+   static_assert(std::is_trivially_copyable<T>::value,
+                 "eytzinger_index stores keys in raw aligned memory");
+public:
+   static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+   // an empty index; so is one that has been moved from
+   eytzinger_index() = default;
+
+   // sorted must be sorted ascending and hold n keys
+   eytzinger_index(const T* sorted, std::size_t n)
+      : n_(n), keys_(allocate<T>(n + 1)), indices_(allocate<Index>(n + 1))
+   {
+      if (n > static_cast<std::size_t>(std::numeric_limits<Index>::max()))
+         throw std::length_error("eytzinger_index: Index type too small");
+      std::size_t next = 0;
+      build(sorted, next, 1);
+      keys_[0] = T();
+      indices_[0] = static_cast<Index>(n);   // "not found": one past the end
+   }
+
+   eytzinger_index(eytzinger_index&& other) noexcept
+      : n_(std::exchange(other.n_, 0)), keys_(std::move(other.keys_)),
+        indices_(std::move(other.indices_)) {}
+
+   eytzinger_index& operator=(eytzinger_index&& other) noexcept
+   {
+      n_ = std::exchange(other.n_, 0);
+      keys_ = std::move(other.keys_);
+      indices_ = std::move(other.indices_);
+      return *this;
+   }
+
+   std::size_t size() const noexcept { return n_; }
+
+   // index in the original array of the first key not less than x,
+   // or size() if every key is less than x
+   std::size_t lower_bound(const T& x) const noexcept
+   {
+      // position 0 would read indices_[0], which an empty index does not have
+      const std::size_t k = position(x);
+      return k != 0 ? indices_[k] : n_;
+   }
+
+   // index in the original array of a key equal to x, or npos
+   std::size_t find(const T& x) const noexcept
+   {
+      const std::size_t k = position(x);
+      return k != 0 && !(x < keys_[k]) ? indices_[k] : npos;
+   }
+
+private:
+   // descendants four levels down start at 16k; prefetch the line holding them
+   static constexpr std::size_t prefetchStride = 16;
+   static constexpr std::size_t cacheLine = 64;
+
+   struct AlignedFree {
+      void operator()(void* p) const noexcept { std::free(p); }
+   };
+
+   template<typename U>
+   using aligned_ptr = std::unique_ptr<U[], AlignedFree>;
+
+   template<typename U>
+   static aligned_ptr<U> allocate(std::size_t n)
+   {
+      const std::size_t bytes = (n * sizeof(U) + cacheLine - 1) / cacheLine * cacheLine;
+      void* p = std::aligned_alloc(cacheLine, bytes);
+      if (!p) throw std::bad_alloc();
+      return aligned_ptr<U>(static_cast<U*>(p));
+   }
+
+   // BFS position of the lower bound of x, 0 if there is none
+   std::size_t position(const T& x) const noexcept
+   {
+      const T* keys = keys_.get();
+      std::size_t k = 1;
+      while (k <= n_) {
+         // near the leaves 16k is past the end of keys; the address is computed
+         // as an integer, since even forming such a pointer is undefined, and a
+         // prefetch of it is harmless
+         prefetch(reinterpret_cast<const void*>(reinterpret_cast<std::uintptr_t>(keys) +
+                                                k * prefetchStride * sizeof(T)));
+         k = 2 * k + (keys[k] < x);
+      }
+      return k >> (trailingOnes(k) + 1);
+   }
+
+   static void prefetch(const void* p) noexcept
+   {
+#if defined(__GNUC__) || defined(__clang__)
+      __builtin_prefetch(p);
+#else
+      (void)p;
+#endif
+   }
+
+   static unsigned trailingOnes(std::size_t k) noexcept
+   {
+#if defined(__GNUC__) || defined(__clang__)
+      return static_cast<unsigned>(__builtin_ctzll(~static_cast<unsigned long long>(k)));
+#else
+      unsigned n = 0;
+      while (k & 1) { k >>= 1; ++n; }
+      return n;
+#endif
+   }
+
+   // in-order walk of the implicit tree assigns sorted keys to BFS positions;
+   // an explicit stack keeps the recursion depth out of the picture
+   void build(const T* sorted, std::size_t& next, std::size_t k)
+   {
+      std::size_t stack[std::numeric_limits<std::size_t>::digits + 1];
+      std::size_t top = 0;
+      for (;;) {
+         while (k <= n_) {
+            stack[top++] = k;
+            k = 2 * k;
+         }
+         if (top == 0) break;
+         k = stack[--top];
+         keys_[k] = sorted[next];
+         indices_[k] = static_cast<Index>(next);
+         ++next;
+         k = 2 * k + 1;
+      }
+   }
+
+   std::size_t n_ = 0;
+   aligned_ptr<T> keys_;
+   aligned_ptr<Index> indices_;
+};
+
+#endif // EYTZINGER_SEARCH_H
@@ -0,0 +1,99 @@
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <utility>
+#include <cstdint>
+#include <cstdlib>
+#include <assert.h>
+
+#include "demo_support.h"
+#include "eytzinger_search.h"
+
+// Searching keyVals without missing the cache at every level
+//
+// template_type_deduction02.cpp pairs a sorted key array with a value array:
+//
+//    int keyVals[] = { 1, 3, 7, 9, 11, 22, 35 };
+//    int mappedVals[arraySize(keyVals)];
+//
+// With seven keys any search is fast. With millions, std::lower_bound spends
+// most of its time waiting for memory. eytzinger_index (eytzinger_search.h)
+// stores the keys in breadth first order with a branchless, prefetching descent
+// and returns indices into the original array, so mappedVals is still indexed
+// exactly as before.
+//
+// The benchmark searches random keys in arrays of 2^10 keys up to 2^maxLog2
+// keys (2^26 by default, pass 30 as the first argument for 1G keys if the
+// machine has the memory) and reports nanoseconds per search for both.
+
+int keyVals[] = { 1, 3, 7, 9, 11, 22, 35 };
+int mappedVals[arraySize(keyVals)] = { 10, 30, 70, 90, 110, 220, 350 };
+
+int main(const int argc, const char* argv[])
+{
+   {
+      eytzinger_index<int> index(keyVals, arraySize(keyVals));
+      for (std::size_t i = 0; i < arraySize(keyVals); ++i) {
+         assert(index.find(keyVals[i]) == i);
+         assert(mappedVals[index.find(keyVals[i])] == keyVals[i] * 10);
+      }
+      assert(index.lower_bound(0) == 0);
+      assert(index.lower_bound(8) == 3);
+      assert(index.lower_bound(36) == arraySize(keyVals));
+      assert(index.find(8) == index.npos);
+
+      const eytzinger_index<int> empty;
+      assert(empty.size() == 0 && empty.lower_bound(1) == 0 && empty.find(1) == empty.npos);
+      eytzinger_index<int> moved(keyVals, arraySize(keyVals));
+      const eytzinger_index<int> target(std::move(moved));
+      assert(moved.size() == 0 && moved.lower_bound(1) == 0 && target.lower_bound(8) == 3);
+
+      for (std::size_t n = 0; n < 70; ++n) {
+         std::vector<int> keys(n);
+         for (std::size_t i = 0; i < n; ++i)
+            keys[i] = static_cast<int>(2 * i);
+         eytzinger_index<int> small(keys.data(), n);
+         for (int x = -1; x <= static_cast<int>(2 * n); ++x) {
+            std::size_t expected = std::lower_bound(keys.begin(), keys.end(), x) - keys.begin();
+            assert(small.lower_bound(x) == expected);
+            (void)expected;
+         }
+      }
+   }
+
+   const int maxLog2 = argc > 1 ? std::atoi(argv[1]) : 26;
+   const std::size_t searches = 1 << 22;
+
+   std::cout << "keys\t    lower_bound ns\t    eytzinger ns" << std::endl;
+   for (int log2 = 10; log2 <= maxLog2; log2 += 2) {
+      const std::size_t n = std::size_t(1) << log2;
+      std::vector<std::uint32_t> keys(n);
+      for (std::size_t i = 0; i < n; ++i)
+         keys[i] = static_cast<std::uint32_t>(3 * i + 1);
+      eytzinger_index<std::uint32_t> index(keys.data(), n);
+
+      std::vector<std::uint32_t> queries(searches);
+      std::uint64_t state = 88172645463325252ULL;
+      for (auto& q : queries) {
+         state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+         q = static_cast<std::uint32_t>(state % (3 * n + 2));
+      }
+
+      std::size_t stdSum = 0, eytzingerSum = 0;
+      double stdNs = timeIt<std::nano>([&] {
+         for (auto q : queries)
+            stdSum += std::lower_bound(keys.begin(), keys.end(), q) - keys.begin();
+      });
+      double eytzingerNs = timeIt<std::nano>([&] {
+         for (auto q : queries)
+            eytzingerSum += index.lower_bound(q);
+      });
+      assert(stdSum == eytzingerSum);
+
+      std::cout << "2^" << log2 << "\t    " << stdNs / searches << "\t    "
+                << eytzingerNs / searches << std::endl;
+   }
+
+   return 0;
+}
@@ -0,0 +1,200 @@
+#ifndef FAST_INT_TO_STRING_H
+#define FAST_INT_TO_STRING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <type_traits>
+#if __cplusplus >= 201703L && __has_include(<charconv>) && !defined(FAST_INT_TO_STRING_NO_CHARCONV)
+#include <charconv>
+#endif
+
+// Fast integer-to-string conversion
+//
+// makeStringDeque() used to turn every integer into a std::string by writing it
+// into a std::stringstream and reading it back out. Each of those round trips
+// goes through the stream's locale (num_put facet, sentry objects, virtual calls
+// into the streambuf) only to produce a handful of ASCII digits.
+//
+// The technique used here is the one behind most std::to_chars implementations:
+// we first count the number of decimal digits, so we know exactly where the
+// last digit goes, and then emit the digits from right to left two at a time,
+// looking each pair up in a 200-byte table of "00".."99". This halves the number
+// of divisions, and the divisions that remain are by a constant, which compilers
+// turn into a multiply and a shift.
+//
+// When <charconv> is available (C++17) intToChars simply forwards to
+// std::to_chars; otherwise the digit-pair code below is the C++11/14 fallback.
+// Defining FAST_INT_TO_STRING_NO_CHARCONV selects the fallback in C++17 too.
+// Both write exactly decimalDigits(value) characters and never a terminator, so
+// callers can size a buffer once and write millions of numbers straight into it.
+
+namespace int_to_string_detail {
+
+constexpr char digitPairs[] =
+   "00010203040506070809"
+   "10111213141516171819"
+   "20212223242526272829"
+   "30313233343536373839"
+   "40414243444546474849"
+   "50515253545556575859"
+   "60616263646566676869"
+   "70717273747576777879"
+   "80818283848586878889"
+   "90919293949596979899";
+
+// number of decimal digits in v (v == 0 has one digit)
+inline unsigned countDigits(std::uint64_t v) noexcept
+{
+   unsigned n = 1;
+   for (;;) {
+      if (v < 10) return n;
+      if (v < 100) return n + 1;
+      if (v < 1000) return n + 2;
+      if (v < 10000) return n + 3;
+      v /= 10000u;
+      n += 4;
+   }
+}
+
+// writes the digits of v so that the last one lands at end[-1]
+template<typename UInt>
+inline void writeDigitsBackwards(char* end, UInt v) noexcept
+{
+   while (v >= 100) {
+      const unsigned pair = static_cast<unsigned>(v % 100) * 2;
+      v /= 100;
+      end -= 2;
+      std::memcpy(end, digitPairs + pair, 2);
+   }
+   if (v >= 10) {
+      end -= 2;
+      std::memcpy(end, digitPairs + static_cast<unsigned>(v) * 2, 2);
+   } else {
+      *--end = static_cast<char>('0' + v);
+   }
+}
+
+template<typename Int>
+inline std::uint64_t magnitude(Int v, std::true_type /* signed */) noexcept
+{
+   // negate in unsigned arithmetic so that the minimum value does not overflow
+   return v < 0 ? 0 - static_cast<std::uint64_t>(v) : static_cast<std::uint64_t>(v);
+}
+
+template<typename Int>
+inline std::uint64_t magnitude(Int v, std::false_type /* unsigned */) noexcept
+{
+   return static_cast<std::uint64_t>(v);
+}
+
+// total number of digits of all integers in [0, n)
+inline std::uint64_t digitsBelow(std::uint64_t n) noexcept
+{
+   std::uint64_t total = 0;
+   std::uint64_t lo = 0, hi = 10;
+   unsigned width = 1;
+   while (lo < n) {
+      const std::uint64_t upper = hi < n ? hi : n;
+      total += (upper - lo) * width;
+      if (hi > std::numeric_limits<std::uint64_t>::max() / 10) {
+         // the next band [hi, 10*hi) would overflow; it is the last one
+         if (n > hi) total += (n - hi) * (width + 1);
+         break;
+      }
+      lo = hi;
+      hi *= 10;
+      ++width;
+   }
+   return total;
+}
+
+} // namespace int_to_string_detail
+
+// largest number of characters intToChars may write for an Int (sign included)
+template<typename Int>
+constexpr std::size_t maxDecimalChars() noexcept
+{
+   return std::numeric_limits<Int>::digits10 + 1 + (std::is_signed<Int>::value ? 1 : 0);
+}
+
+// number of characters intToChars writes for value (sign included)
+template<typename Int>
+inline std::size_t decimalDigits(Int value) noexcept
+{
+   static_assert(std::is_integral<Int>::value, "decimalDigits requires an integer");
+   return int_to_string_detail::countDigits(
+             int_to_string_detail::magnitude(value, std::is_signed<Int>())) +
+          (value < 0 ? 1 : 0);
+}
+
+// writes value in decimal starting at out and returns one past the last
+// character written. out must have room for decimalDigits(value) characters.
+template<typename Int>
+inline char* intToChars(char* out, Int value) noexcept
+{
+   static_assert(std::is_integral<Int>::value, "intToChars requires an integer");
+#if defined(__cpp_lib_to_chars) && !defined(FAST_INT_TO_STRING_NO_CHARCONV)
+   // the end must stay within the caller's buffer, which may be exactly sized
+   return std::to_chars(out, out + decimalDigits(value), value).ptr;
+#else
+   const std::uint64_t mag =
+      int_to_string_detail::magnitude(value, std::is_signed<Int>());
+   if (value < 0) *out++ = '-';
+   char* end = out + int_to_string_detail::countDigits(mag);
+   if (mag <= std::numeric_limits<std::uint32_t>::max())
+      int_to_string_detail::writeDigitsBackwards(end, static_cast<std::uint32_t>(mag));
+   else
+      int_to_string_detail::writeDigitsBackwards(end, mag);
+   return end;
+#endif
+}
+
+template<typename Int>
+inline std::string intToString(Int value)
+{
+   char buf[maxDecimalChars<Int>()];
+   return std::string(buf, intToChars(buf, value));
+}
+
+// total number of characters needed to print every integer in [first, last),
+// computed band by band rather than number by number; use it to preallocate
+// a single buffer before a bulk writeIntRange
+template<typename Int>
+inline std::size_t decimalRangeLength(Int first, Int last) noexcept
+{
+   static_assert(std::is_integral<Int>::value, "decimalRangeLength requires an integer");
+   using namespace int_to_string_detail;
+   if (!(first < last)) return 0;
+   std::uint64_t total = 0;
+   if (first < 0) {
+      // negatives in [first, min(last, 0)): magnitudes in [-min(last,0)+1, -first+1)
+      const Int negEnd = last < 0 ? last : Int(0);
+      const std::uint64_t hiMag = magnitude(first, std::is_signed<Int>()) + 1;
+      const std::uint64_t loMag = magnitude(negEnd, std::is_signed<Int>()) + 1;
+      total += digitsBelow(hiMag) - digitsBelow(loMag) + (hiMag - loMag);
+      first = negEnd;
+   }
+   if (first < last)
+      total += digitsBelow(static_cast<std::uint64_t>(last)) -
+               digitsBelow(static_cast<std::uint64_t>(first));
+   return static_cast<std::size_t>(total);
+}
+
+// writes every integer in [first, last) back to back starting at out, calling
+// onEach(begin, end) for each one written, and returns one past the last
+// character. out must have room for decimalRangeLength(first, last) characters.
+template<typename Int, typename OnEach>
+inline char* writeIntRange(char* out, Int first, Int last, OnEach&& onEach)
+{
+   for (Int i = first; i < last; ++i) {
+      char* end = intToChars(out, i);
+      onEach(static_cast<const char*>(out), static_cast<const char*>(end));
+      out = end;
+   }
+   return out;
+}
+
+#endif // FAST_INT_TO_STRING_H
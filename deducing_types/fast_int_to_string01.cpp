@@ -0,0 +1,139 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <deque>
+#include <vector>
+#include <chrono>
+#include <utility>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <assert.h>
+
+#include "demo_support.h"
+#include "fast_int_to_string.h"
+
+// Generating numeric strings without a stringstream
+//
+// makeStringDeque() from understand_decltype01.cpp originally produced its
+// elements like this:
+//
+//    std::stringstream stream;
+//    for (int i=1; i<10; ++i) {
+//        stream << i;
+//        std::string str;
+//        stream >> str;
+//        res.push_back(str);
+//    }
+//
+// That is fine for nine elements, but every iteration pays for a formatted
+// insertion and a formatted extraction through the stream's locale, plus a
+// std::string that is constructed, filled and then copied into the deque.
+// fast_int_to_string.h replaces all of this with intToChars, which counts the
+// digits first and then writes them right to left, two at a time, from a table
+// of digit pairs.
+//
+// Below we compare three ways of producing the strings "0", "1", ..., "n-1":
+//
+// 1. the original stringstream round trip into a std::deque<std::string>
+// 2. intToString into a std::deque<std::string>
+// 3. writeIntRange into one preallocated char buffer plus an offsets array,
+//    sized up front with decimalRangeLength
+//
+// The third variant is what you want when millions of strings are generated:
+// there is exactly one allocation for the characters and one for the offsets.
+//
+// In C++17 intToChars forwards to std::to_chars. The same file is also built
+// as C++14, fast_int_to_string01_fallback, so the digit-pair code is checked
+// and timed as well.
+
+std::deque<std::string> makeStringDequeStream(int n) {
+   std::deque<std::string> res;
+   std::stringstream stream;
+   for (int i = 0; i < n; ++i) {
+      stream << i;
+      std::string str;
+      stream >> str;
+      stream.clear();
+      res.push_back(str);
+   }
+   return res;
+}
+
+std::deque<std::string> makeStringDequeFast(int n) {
+   std::deque<std::string> res;
+   for (int i = 0; i < n; ++i)
+      res.push_back(intToString(i));
+   return res;
+}
+
+struct PackedStrings {
+   std::vector<char> chars;
+   std::vector<std::size_t> ends;    // ends[i] is one past the last char of string i
+};
+
+PackedStrings makePackedStrings(int n) {
+   PackedStrings res;
+   res.chars.resize(decimalRangeLength(0, n));
+   res.ends.reserve(n);
+   const char* base = res.chars.data();
+   writeIntRange(res.chars.data(), 0, n,
+                 [&](const char*, const char* end) { res.ends.push_back(end - base); });
+   return res;
+}
+
+void checkConversions()
+{
+   const long long samples[] = { 0, 1, 9, 10, 99, 100, 101, 4294967295LL, 4294967296LL,
+                                 -1, -10, -4294967296LL,
+                                 std::numeric_limits<long long>::max(),
+                                 std::numeric_limits<long long>::min() };
+   for (long long v : samples) {
+      assert(intToString(v) == std::to_string(v));
+      assert(decimalDigits(v) == std::to_string(v).size());
+      (void)v;
+   }
+   assert(intToString(std::numeric_limits<unsigned long long>::max()) ==
+          std::to_string(std::numeric_limits<unsigned long long>::max()));
+
+   const int ranges[][2] = { {0, 1}, {0, 1000}, {-1000, 1000}, {-57, -3}, {95, 12345} };
+   for (const auto& r : ranges) {
+      std::size_t expected = 0;
+      for (int i = r[0]; i < r[1]; ++i)
+         expected += std::to_string(i).size();
+      assert(decimalRangeLength(r[0], r[1]) == expected);
+   }
+}
+
+int main(const int argc, const char* argv[])
+{
+   checkConversions();
+
+   const int n = argc > 1 ? std::atoi(argv[1]) : 2000000;
+
+   std::size_t sink = 0;
+   double streamMs = timeIt([&] { sink += makeStringDequeStream(n).size(); });
+   double fastMs = timeIt([&] { sink += makeStringDequeFast(n).size(); });
+   double packedMs = timeIt([&] { sink += makePackedStrings(n).ends.size(); });
+
+   PackedStrings packed = makePackedStrings(n);
+   std::deque<std::string> reference = makeStringDequeStream(n < 1000 ? n : 1000);
+   for (std::size_t i = 0; i < reference.size(); ++i) {
+      std::size_t begin = i == 0 ? 0 : packed.ends[i - 1];
+      assert(std::string(packed.chars.data() + begin, packed.chars.data() + packed.ends[i]) ==
+             reference[i]);
+      (void)begin;
+   }
+
+#if defined(__cpp_lib_to_chars) && !defined(FAST_INT_TO_STRING_NO_CHARCONV)
+   std::cout << n << " strings (intToChars: std::to_chars)" << std::endl;
+#else
+   std::cout << n << " strings (intToChars: digit pairs)" << std::endl;
+#endif
+   std::cout << "stringstream -> deque<string>:  " << streamMs << " ms" << std::endl;
+   std::cout << "intToString  -> deque<string>:  " << fastMs << " ms" << std::endl;
+   std::cout << "writeIntRange -> packed buffer: " << packedMs << " ms" << std::endl;
+   std::cout << "(checksum " << sink << ")" << std::endl;
+
+   return 0;
+}
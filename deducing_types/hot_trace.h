@@ -0,0 +1,459 @@
+#ifndef HOT_TRACE_H
+#define HOT_TRACE_H
+
+// Scoped tracing for hot paths
+//
+// A profiler tells us that authAndAccess is hot, but not which of its calls
+// were slow, or what the other threads were doing at the time. A trace does:
+// every traced scope becomes one event with a start time and a duration, and
+// chrome://tracing or https://ui.perfetto.dev show them on one timeline per
+// thread.
+//
+//    HOT_TRACE_START("trace.json");
+//    ...
+//    decltype(auto) authAndAccess(Container&& c, Index i)
+//    {
+//       HOT_TRACE_SCOPE("authAndAccess");
+//       authenticateUser();
+//       return std::forward<Container>(c)[i];
+//    }
+//    ...
+//    HOT_TRACE_STOP();
+//
+// Recording has to be cheap enough to leave in code that runs millions of
+// times per second, so a scope
+//
+//  * reads the time stamp counter when it starts and when it ends (a few
+//    cycles; steady_clock only where there is no TSC) and converts ticks to
+//    time only when the trace is written,
+//  * takes its name as a pointer to a string literal, never a copy, and
+//  * appends one 32 byte event to a ring owned by its thread, an spsc_queue
+//    (ring_queue.h) whose only consumer is the flusher. No lock, no allocation
+//    and no shared cache line on the way; a full ring drops the event and
+//    counts it rather than wait.
+//
+// A background thread drains the rings every millisecond. Draining only copies
+// the raw events into a queue in memory, a few nanoseconds each, so the rings
+// are emptied long before they fill up. Formatting an event as Chrome trace
+// event JSON takes far longer; the same thread does it afterwards, a slice of
+// events at a time between two drains, and appends the text to the file. A long
+// run does not keep its trace in memory unless the threads produce events
+// faster, for a long time, than one thread can format them.
+//
+// Tracing is compiled in only when HOT_TRACE_ENABLED is defined to 1. Otherwise
+// every macro expands to nothing, the code below is not even compiled, and a
+// traced function is exactly the function without its trace points.
+
+#ifndef HOT_TRACE_ENABLED
+#define HOT_TRACE_ENABLED 0
+#endif
+
+#if HOT_TRACE_ENABLED
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "fast_int_to_string.h"
+#include "ring_queue.h"
+
+#ifndef HOT_TRACE_RING_EVENTS
+#define HOT_TRACE_RING_EVENTS 65536            // per thread
+#endif
+
+#ifndef HOT_TRACE_WRITE_SLICE
+#define HOT_TRACE_WRITE_SLICE 4096             // events formatted between two drains
+#endif
+
+namespace hot_trace {
+
+inline std::uint64_t ticks() noexcept
+{
+#if defined(__x86_64__) || defined(__i386__)
+   return __rdtsc();
+#else
+   return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+struct event {
+   const char* name;
+   std::uint64_t start;                        // ticks
+   std::uint64_t duration;                     // ticks
+   char phase;                                 // 'X' complete, 'i' instant
+};
+
+static_assert(sizeof(event) <= 32, "trace events are meant to stay small");
+
+// the events of one thread, kept alive by the tracer until they are written
+struct thread_buffer {
+   explicit thread_buffer(std::uint32_t id) : tid(id), ring(HOT_TRACE_RING_EVENTS) {}
+
+   const std::uint32_t tid;
+   spsc_queue<event> ring;
+   std::atomic<std::uint64_t> dropped{ 0 };    // written by the owning thread only
+   std::atomic<const char*> threadName{ nullptr };
+   std::atomic<bool> exited{ false };
+};
+
+class tracer {
+public:
+   static tracer& instance()
+   {
+      static tracer t;
+      return t;
+   }
+
+   tracer(const tracer&) = delete;
+   tracer& operator=(const tracer&) = delete;
+
+   ~tracer() { stop(); }
+
+   // false while no trace is being written; scopes then record nothing
+   bool active() const noexcept { return active_.load(std::memory_order_relaxed); }
+
+   // starts writing the trace to path, draining the rings every interval
+   void start(const char* path,
+              std::chrono::milliseconds interval = std::chrono::milliseconds(1))
+   {
+      std::lock_guard<std::mutex> lock(control_);
+      if (out_) throw std::logic_error("hot_trace: a trace is already being written");
+      out_ = std::fopen(path, "w");
+      if (!out_) throw std::runtime_error(std::string("hot_trace: cannot open ") + path);
+      std::fputs("{\"traceEvents\":[\n", out_);
+      first_ = true;
+      calibrate();
+      {
+         std::lock_guard<std::mutex> flushLock(flushMutex_);
+         stopping_ = false;
+      }
+      active_.store(true, std::memory_order_relaxed);
+      flusher_ = std::thread([this, interval] { flushLoop(interval); });
+   }
+
+   // writes what is left and closes the trace
+   void stop()
+   {
+      std::lock_guard<std::mutex> lock(control_);
+      if (!out_) return;
+      active_.store(false, std::memory_order_relaxed);
+      {
+         std::lock_guard<std::mutex> flushLock(flushMutex_);
+         stopping_ = true;
+      }
+      wake_.notify_one();
+      flusher_.join();
+      drain();                                 // the flusher is gone, we are the consumer now
+      write(pending_.size());
+      writeThreadNames();
+      std::fprintf(out_, "\n],\"displayTimeUnit\":\"ns\",\"otherData\":{\"droppedEvents\":%llu}}\n",
+                   static_cast<unsigned long long>(dropped()));
+      std::fclose(out_);
+      out_ = nullptr;
+   }
+
+   // events lost to full rings so far
+   std::uint64_t dropped() const
+   {
+      std::lock_guard<std::mutex> lock(buffersMutex_);
+      std::uint64_t n = retiredDropped_;
+      for (const auto& b : buffers_)
+         n += b->dropped.load(std::memory_order_relaxed);
+      return n;
+   }
+
+   // the calling thread's ring, registered on first use
+   thread_buffer& local()
+   {
+      if (!current_) current_ = registerThread();
+      return *current_;
+   }
+
+   void record(const event& e)
+   {
+      thread_buffer& b = local();
+      if (!b.ring.try_push(event(e)))
+         b.dropped.store(b.dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+   }
+
+private:
+   tracer() = default;
+
+   // marks the ring of an exiting thread so that the flusher can let it go
+   struct thread_exit {
+      std::shared_ptr<thread_buffer> buffer;
+      ~thread_exit()
+      {
+         current_ = nullptr;
+         if (buffer) buffer->exited.store(true, std::memory_order_release);
+      }
+   };
+
+   thread_buffer* registerThread()
+   {
+      static thread_local thread_exit owner;
+      std::lock_guard<std::mutex> lock(buffersMutex_);
+      owner.buffer = std::make_shared<thread_buffer>(nextTid_++);
+      buffers_.push_back(owner.buffer);
+      return owner.buffer.get();
+   }
+
+   // ticks per nanosecond, measured against steady_clock
+   void calibrate()
+   {
+      using namespace std::chrono;
+      const auto t0 = steady_clock::now();
+      const std::uint64_t c0 = ticks();
+      std::this_thread::sleep_for(milliseconds(20));
+      const auto t1 = steady_clock::now();
+      const std::uint64_t c1 = ticks();
+      ticksPerNs_ = static_cast<double>(c1 - c0) / duration<double, std::nano>(t1 - t0).count();
+      originTicks_ = c1;
+   }
+
+   // an event with the thread it came from, waiting to be written
+   struct pending_event {
+      const char* name;
+      std::uint64_t start;
+      std::uint64_t duration;
+      std::uint32_t tid;
+      char phase;
+   };
+
+   void flushLoop(std::chrono::milliseconds interval)
+   {
+      std::unique_lock<std::mutex> lock(flushMutex_);
+      while (!stopping_) {
+         if (pending_.empty())
+            wake_.wait_for(lock, interval, [this] { return stopping_; });
+         lock.unlock();
+         drain();
+         write(HOT_TRACE_WRITE_SLICE);
+         lock.lock();
+      }
+   }
+
+   // moves the events of every ring to pending_; only ever one caller at a time
+   void drain()
+   {
+      std::vector<std::shared_ptr<thread_buffer>> buffers;
+      {
+         std::lock_guard<std::mutex> lock(buffersMutex_);
+         buffers = buffers_;
+      }
+      event batch[256];
+      for (const auto& b : buffers) {
+         const bool exited = b->exited.load(std::memory_order_acquire);
+         while (std::size_t n = b->ring.pop_batch(batch, 256))
+            for (std::size_t i = 0; i < n; ++i)
+               pending_.push_back(pending_event{ batch[i].name, batch[i].start, batch[i].duration,
+                                                 b->tid, batch[i].phase });
+         if (exited) retire(b);
+      }
+   }
+
+   // formats and writes up to n pending events
+   void write(std::size_t n)
+   {
+      n = std::min(n, pending_.size());
+      if (n == 0) return;
+      text_.clear();
+      for (std::size_t i = 0; i < n; ++i)
+         append(text_, pending_[i]);
+      pending_.erase(pending_.begin(), pending_.begin() + static_cast<std::ptrdiff_t>(n));
+      std::fwrite(text_.data(), 1, text_.size(), out_);
+      std::fflush(out_);
+   }
+
+   void retire(const std::shared_ptr<thread_buffer>& b)
+   {
+      std::lock_guard<std::mutex> lock(buffersMutex_);
+      retiredDropped_ += b->dropped.load(std::memory_order_relaxed);
+      if (const char* name = b->threadName.load(std::memory_order_relaxed))
+         retiredNames_.emplace_back(b->tid, name);
+      for (std::size_t i = 0; i < buffers_.size(); ++i)
+         if (buffers_[i] == b) {
+            buffers_.erase(buffers_.begin() + i);
+            break;
+         }
+   }
+
+   // ticks as microseconds with three decimals
+   static void appendMicroseconds(std::string& text, double ns)
+   {
+      std::int64_t n = static_cast<std::int64_t>(ns + (ns < 0 ? -0.5 : 0.5));
+      if (n < 0) {
+         text += '-';
+         n = -n;
+      }
+      char buf[maxDecimalChars<std::int64_t>()];
+      text.append(buf, intToChars(buf, n / 1000));
+      const int frac = static_cast<int>(n % 1000);
+      text += '.';
+      text += static_cast<char>('0' + frac / 100);
+      text += static_cast<char>('0' + frac / 10 % 10);
+      text += static_cast<char>('0' + frac % 10);
+   }
+
+   // a JSON string: quotes, backslashes and control characters escaped
+   static void appendString(std::string& text, const char* s)
+   {
+      static const char hex[] = "0123456789abcdef";
+      text += '"';
+      for (; *s; ++s) {
+         const unsigned char c = static_cast<unsigned char>(*s);
+         if (c == '"' || c == '\\') {
+            text += '\\';
+            text += static_cast<char>(c);
+         } else if (c < 0x20) {
+            text += "\\u00";
+            text += hex[c >> 4];
+            text += hex[c & 15];
+         } else {
+            text += static_cast<char>(c);
+         }
+      }
+      text += '"';
+   }
+
+   static void appendTid(std::string& text, std::uint32_t tid)
+   {
+      char buf[maxDecimalChars<std::uint32_t>()];
+      text += ",\"pid\":1,\"tid\":";
+      text.append(buf, intToChars(buf, tid));
+   }
+
+   void append(std::string& text, const pending_event& e)
+   {
+      text += first_ ? "{\"name\":" : ",\n{\"name\":";
+      first_ = false;
+      appendString(text, e.name);
+      text += e.phase == 'X' ? ",\"ph\":\"X\",\"ts\":" : ",\"ph\":\"i\",\"s\":\"t\",\"ts\":";
+      appendMicroseconds(text, static_cast<double>(static_cast<std::int64_t>(e.start - originTicks_)) /
+                                  ticksPerNs_);
+      if (e.phase == 'X') {
+         text += ",\"dur\":";
+         appendMicroseconds(text, static_cast<double>(e.duration) / ticksPerNs_);
+      }
+      appendTid(text, e.tid);
+      text += '}';
+   }
+
+   void writeThreadNames()
+   {
+      std::lock_guard<std::mutex> lock(buffersMutex_);
+      text_.clear();
+      auto add = [this](std::uint32_t tid, const char* name) {
+         text_ += first_ ? "{\"name\":\"thread_name\",\"ph\":\"M\""
+                         : ",\n{\"name\":\"thread_name\",\"ph\":\"M\"";
+         first_ = false;
+         appendTid(text_, tid);
+         text_ += ",\"args\":{\"name\":";
+         appendString(text_, name);
+         text_ += "}}";
+      };
+      for (const auto& n : retiredNames_)
+         add(n.first, n.second);
+      for (const auto& b : buffers_)
+         if (const char* name = b->threadName.load(std::memory_order_relaxed))
+            add(b->tid, name);
+      std::fwrite(text_.data(), 1, text_.size(), out_);
+   }
+
+   static inline thread_local thread_buffer* current_ = nullptr;
+
+   std::atomic<bool> active_{ false };
+   std::mutex control_;                        // start and stop
+
+   mutable std::mutex buffersMutex_;
+   std::vector<std::shared_ptr<thread_buffer>> buffers_;
+   std::vector<std::pair<std::uint32_t, const char*>> retiredNames_;
+   std::uint64_t retiredDropped_ = 0;
+   std::uint32_t nextTid_ = 1;
+
+   std::mutex flushMutex_;
+   std::condition_variable wake_;
+   bool stopping_ = false;
+   std::thread flusher_;
+
+   // used by the flusher, or by stop once the flusher has been joined
+   std::deque<pending_event> pending_;
+   std::string text_;
+   std::FILE* out_ = nullptr;
+   bool first_ = true;
+   double ticksPerNs_ = 1;
+   std::uint64_t originTicks_ = 0;
+};
+
+// records the time from its construction to its destruction as one event
+class scope {
+public:
+   explicit scope(const char* name) noexcept
+      : name_(tracer::instance().active() ? name : nullptr), start_(name_ ? ticks() : 0) {}
+
+   scope(const scope&) = delete;
+   scope& operator=(const scope&) = delete;
+
+   ~scope()
+   {
+      if (name_) tracer::instance().record(event{ name_, start_, ticks() - start_, 'X' });
+   }
+
+private:
+   const char* name_;
+   std::uint64_t start_;
+};
+
+inline void instant(const char* name)
+{
+   tracer& t = tracer::instance();
+   if (t.active()) t.record(event{ name, ticks(), 0, 'i' });
+}
+
+// names the calling thread's row in the trace viewer
+inline void nameThread(const char* name)
+{
+   tracer::instance().local().threadName.store(name, std::memory_order_relaxed);
+}
+
+} // namespace hot_trace
+
+#define HOT_TRACE_CONCAT2(a, b) a##b
+#define HOT_TRACE_CONCAT(a, b) HOT_TRACE_CONCAT2(a, b)
+
+// names must be string literals; "" name "" refuses anything else
+#define HOT_TRACE_SCOPE(name) \
+   ::hot_trace::scope HOT_TRACE_CONCAT(hotTraceScope, __LINE__)("" name "")
+#define HOT_TRACE_FUNCTION() \
+   ::hot_trace::scope HOT_TRACE_CONCAT(hotTraceScope, __LINE__)(__func__)
+#define HOT_TRACE_INSTANT(name) ::hot_trace::instant("" name "")
+#define HOT_TRACE_THREAD_NAME(name) ::hot_trace::nameThread("" name "")
+#define HOT_TRACE_START(path) ::hot_trace::tracer::instance().start(path)
+#define HOT_TRACE_STOP() ::hot_trace::tracer::instance().stop()
+
+#else
+
+#define HOT_TRACE_SCOPE(name) static_cast<void>(0)
+#define HOT_TRACE_FUNCTION() static_cast<void>(0)
+#define HOT_TRACE_INSTANT(name) static_cast<void>(0)
+#define HOT_TRACE_THREAD_NAME(name) static_cast<void>(0)
+#define HOT_TRACE_START(path) static_cast<void>(0)
+#define HOT_TRACE_STOP() static_cast<void>(0)
+
+#endif // HOT_TRACE_ENABLED
+
+#endif // HOT_TRACE_H
@@ -0,0 +1,154 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <utility>
+#include <cstdlib>
+#include <assert.h>
+
+#include "fast_int_to_string.h"
+
+// A worker here records an event every few nanoseconds, far faster than the
+// flusher can write them. Rings big enough for a whole default run keep the
+// trace complete even where the flusher gets only its share of a single core.
+const long defaultIterations = 100000;
+#define HOT_TRACE_RING_EVENTS (1 << 19)
+#include "hot_trace.h"
+
+// Tracing authAndAccess
+//
+// The functions from understand_decltype01.cpp and
+// use_explicitly_typed_initializer01.cpp, with a trace point in each:
+// authAndAccess -> authenticateUser, makeStringDeque, and
+// features -> processWidget. Several threads run them in a loop while the
+// trace is written to hot_trace.json (or the file given as the first
+// argument); open it in chrome://tracing or https://ui.perfetto.dev.
+//
+// The same file is built twice, as hot_trace01 with HOT_TRACE_ENABLED=1 and
+// as hot_trace01_off without it, so the time per iteration of the two builds
+// shows what the trace points cost.
+
+void authenticateUser() {
+   HOT_TRACE_SCOPE("authenticateUser");
+   // do some authentication
+};
+
+template<typename Container, typename Index>
+auto
+authAndAccess(Container&& c, Index i)
+-> decltype(std::forward<Container>(c)[i])
+{
+   HOT_TRACE_SCOPE("authAndAccess");
+   authenticateUser();
+   return std::forward<Container>(c)[i];
+}
+
+std::deque<std::string> makeStringDeque() {
+   HOT_TRACE_FUNCTION();
+   std::deque<std::string> res;
+   char buf[maxDecimalChars<int>()];
+   for (int i=1; i<10; ++i) {
+       res.emplace_back(buf, intToChars(buf, i));
+   }
+   return res;
+};
+
+struct Widget {
+   int id;
+};
+
+std::vector<bool> features(const Widget& w) {
+   HOT_TRACE_SCOPE("features");
+   return { true, true, false, true, false, w.id % 2 == 0 };
+};
+
+bool processWidget(const Widget& w, bool highPriority) {
+   HOT_TRACE_SCOPE("processWidget");
+   return highPriority || w.id % 3 == 0;
+};
+
+// four traced scopes per iteration
+long work(const std::deque<std::string>& d, long iterations)
+{
+   long sum = 0;
+   for (long i = 0; i < iterations; ++i) {
+      sum += authAndAccess(d, i % 9).size();
+      const Widget w{ static_cast<int>(i) };
+      const bool highPriority = features(w)[5];
+      sum += processWidget(w, highPriority);
+   }
+   return sum;
+}
+
+int main(const int argc, const char* argv[])
+{
+   const char* path = argc > 1 ? argv[1] : "hot_trace.json";
+   const long iterations = argc > 2 ? std::atol(argv[2]) : defaultIterations;
+   const unsigned threads = 4;
+
+   HOT_TRACE_START(path);
+   HOT_TRACE_THREAD_NAME("main");
+
+   auto s = authAndAccess(makeStringDeque(), 5);
+   assert(s == "6");
+   HOT_TRACE_INSTANT("first lookup done");
+
+   std::vector<long> sums(threads);
+   const auto start = std::chrono::steady_clock::now();
+   std::vector<std::thread> workers;
+   for (unsigned t = 0; t < threads; ++t)
+      workers.emplace_back([&, t] {
+         HOT_TRACE_THREAD_NAME("worker");
+         const std::deque<std::string> d = makeStringDeque();
+         sums[t] = work(d, iterations);
+      });
+   for (auto& w : workers) w.join();
+   const double ms = std::chrono::duration<double, std::milli>(
+      std::chrono::steady_clock::now() - start).count();
+   for (long sum : sums) {
+      assert(sum == sums[0]);
+      (void)sum;
+   }
+
+#if HOT_TRACE_ENABLED
+   const std::uint64_t dropped = hot_trace::tracer::instance().dropped();
+#endif
+   HOT_TRACE_STOP();
+
+   std::cout << threads << " threads x " << iterations << " iterations: " << ms << " ms, "
+             << ms * 1e6 / (threads * iterations) << " ns per iteration ("
+             << (HOT_TRACE_ENABLED ? "traced" : "tracing compiled out") << ", checksum "
+             << sums[0] << ")" << std::endl;
+
+#if HOT_TRACE_ENABLED
+   std::ifstream in(path);
+   std::stringstream text;
+   text << in.rdbuf();
+   const std::string trace = text.str();
+   std::size_t events = 0;
+   for (std::size_t p = trace.find("\"ph\":\"X\""); p != std::string::npos;
+        p = trace.find("\"ph\":\"X\"", p + 1))
+      ++events;
+   // the first lookup: makeStringDeque, authAndAccess and authenticateUser;
+   // then one makeStringDeque and four scopes per iteration per thread
+   const std::size_t expected = 3 + threads * (1 + 4 * iterations);
+   assert(trace.compare(0, 16, "{\"traceEvents\":[") == 0);
+   assert(trace.find("\"name\":\"thread_name\"") != std::string::npos);
+   assert(events + dropped == expected);
+   // at most one event in a hundred may be lost, as long as the rings can hold
+   // a run; longer ones depend on how much CPU time the flusher gets
+   if (iterations <= defaultIterations)
+      assert(dropped * 100 <= expected);
+   (void)expected;
+   std::cout << events << " events written to " << path << ", " << dropped
+             << " dropped by full rings" << std::endl;
+#else
+   (void)path;
+#endif
+
+   return 0;
+}
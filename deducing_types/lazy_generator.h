@@ -0,0 +1,316 @@
+#ifndef LAZY_GENERATOR_H
+#define LAZY_GENERATOR_H
+
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#if __cplusplus >= 202002L && __has_include(<coroutine>)
+#include <coroutine>
+#endif
+
+// Lazy sequences
+//
+// authAndAccess3(makeStringDeque(), 5) builds nine strings, keeps one and throws
+// the rest away. A lazy sequence turns this around: it stores only the recipe
+// for its elements and produces an element when somebody asks for it.
+//
+// lazy_sequence<Producer> (C++14) accepts two kinds of producers:
+//
+// * an indexed producer, callable as producer(i), computes the i-th element
+//   directly. The sequence then offers operator[] and random access iterators,
+//   and authAndAccess(seq, 5) computes exactly one element.
+//
+// * a sequential producer, callable as producer() and returning the next
+//   element each time, is the only option when element i depends on element
+//   i-1. The sequence then offers input iterators; operator[] still exists but
+//   has to step through the first i elements on a copy of the producer.
+//
+// Which kind we have is detected from whether Producer can be called with a
+// std::size_t. Neither kind ever materializes more than one element at a time.
+//
+// With C++20 coroutines the sequential case can be written as an ordinary
+// function that co_yields its elements; generator<T> at the end of this file
+// is the minimal return type such a coroutine needs.
+
+namespace lazy_generator_detail {
+
+template<typename F, typename = void>
+struct is_indexed_producer : std::false_type {};
+
+template<typename F>
+struct is_indexed_producer<F,
+   decltype(void(std::declval<F&>()(std::declval<std::size_t>())))> : std::true_type {};
+
+template<typename F, bool Indexed = is_indexed_producer<F>::value>
+struct producer_result {
+   using type = std::decay_t<decltype(std::declval<F&>()(std::declval<std::size_t>()))>;
+};
+
+template<typename F>
+struct producer_result<F, false> {
+   using type = std::decay_t<decltype(std::declval<F&>()())>;
+};
+
+} // namespace lazy_generator_detail
+
+template<typename Producer,
+         bool Indexed = lazy_generator_detail::is_indexed_producer<Producer>::value>
+class lazy_sequence;
+
+// indexed producer: element i is producer(i)
+template<typename Producer>
+class lazy_sequence<Producer, true> {
+public:
+   using value_type = typename lazy_generator_detail::producer_result<Producer>::type;
+   using size_type = std::size_t;
+
+   class iterator {
+   public:
+      using iterator_category = std::random_access_iterator_tag;
+      using value_type = lazy_sequence::value_type;
+      using difference_type = std::ptrdiff_t;
+      using pointer = void;
+      using reference = value_type;
+
+      iterator() = default;
+      iterator(const lazy_sequence* seq, size_type i) : seq_(seq), i_(i) {}
+
+      value_type operator*() const { return (*seq_)[i_]; }
+      value_type operator[](difference_type n) const { return (*seq_)[i_ + n]; }
+
+      iterator& operator++() { ++i_; return *this; }
+      iterator operator++(int) { iterator t = *this; ++i_; return t; }
+      iterator& operator--() { --i_; return *this; }
+      iterator operator--(int) { iterator t = *this; --i_; return t; }
+      iterator& operator+=(difference_type n) { i_ += n; return *this; }
+      iterator& operator-=(difference_type n) { i_ -= n; return *this; }
+      friend iterator operator+(iterator it, difference_type n) { return it += n; }
+      friend iterator operator+(difference_type n, iterator it) { return it += n; }
+      friend iterator operator-(iterator it, difference_type n) { return it -= n; }
+      friend difference_type operator-(const iterator& a, const iterator& b)
+      { return static_cast<difference_type>(a.i_) - static_cast<difference_type>(b.i_); }
+
+      friend bool operator==(const iterator& a, const iterator& b) { return a.i_ == b.i_; }
+      friend bool operator!=(const iterator& a, const iterator& b) { return a.i_ != b.i_; }
+      friend bool operator<(const iterator& a, const iterator& b) { return a.i_ < b.i_; }
+      friend bool operator>(const iterator& a, const iterator& b) { return a.i_ > b.i_; }
+      friend bool operator<=(const iterator& a, const iterator& b) { return a.i_ <= b.i_; }
+      friend bool operator>=(const iterator& a, const iterator& b) { return a.i_ >= b.i_; }
+
+   private:
+      const lazy_sequence* seq_ = nullptr;
+      size_type i_ = 0;
+   };
+   using const_iterator = iterator;
+
+   lazy_sequence(size_type n, Producer producer)
+      : n_(n), producer_(std::move(producer)) {}
+
+   value_type operator[](size_type i) const { return producer_(i); }
+
+   size_type size() const noexcept { return n_; }
+   bool empty() const noexcept { return n_ == 0; }
+
+   iterator begin() const { return iterator(this, 0); }
+   iterator end() const { return iterator(this, n_); }
+
+private:
+   size_type n_;
+   mutable Producer producer_;
+};
+
+// sequential producer: each call to producer() yields the next element
+template<typename Producer>
+class lazy_sequence<Producer, false> {
+public:
+   using value_type = typename lazy_generator_detail::producer_result<Producer>::type;
+   using size_type = std::size_t;
+
+   class iterator {
+   public:
+      using iterator_category = std::input_iterator_tag;
+      using value_type = lazy_sequence::value_type;
+      using difference_type = std::ptrdiff_t;
+      using pointer = const value_type*;
+      using reference = const value_type&;
+
+      iterator() = default;
+
+      reference operator*() const { return state_->value; }
+      pointer operator->() const { return std::addressof(state_->value); }
+
+      iterator& operator++() { state_->advance(); return *this; }
+      void operator++(int) { state_->advance(); }
+
+      friend bool operator==(const iterator& a, const iterator& b)
+      { return a.remaining() == b.remaining(); }
+      friend bool operator!=(const iterator& a, const iterator& b)
+      { return a.remaining() != b.remaining(); }
+
+   private:
+      friend class lazy_sequence;
+
+      // the producer and the current element, allocated once per pass and
+      // shared by copies of the iterator, as input iterators are single pass
+      struct state {
+         state(Producer p, size_type n) : producer(std::move(p)), remaining(n + 1) {}
+         state(const state&) = delete;
+         state& operator=(const state&) = delete;
+         ~state() { reset(); }
+
+         void advance()
+         {
+            reset();
+            if (--remaining != 0) {
+               ::new (static_cast<void*>(std::addressof(value))) value_type(producer());
+               engaged = true;
+            }
+         }
+
+         void reset() noexcept
+         {
+            if (engaged) {
+               value.~value_type();
+               engaged = false;
+            }
+         }
+
+         Producer producer;
+         size_type remaining;
+         bool engaged = false;
+         union { value_type value; };          // constructed while engaged
+      };
+
+      iterator(Producer producer, size_type n)
+         : state_(std::make_shared<state>(std::move(producer), n))
+      { state_->advance(); }
+
+      size_type remaining() const noexcept { return state_ ? state_->remaining : 0; }
+
+      std::shared_ptr<state> state_;
+   };
+   using const_iterator = iterator;
+
+   lazy_sequence(size_type n, Producer producer)
+      : n_(n), producer_(std::move(producer)) {}
+
+   // no direct access: step a fresh copy of the producer i times
+   value_type operator[](size_type i) const
+   {
+      Producer p = producer_;
+      for (size_type k = 0; k < i; ++k)
+         (void)p();
+      return p();
+   }
+
+   size_type size() const noexcept { return n_; }
+   bool empty() const noexcept { return n_ == 0; }
+
+   iterator begin() const { return iterator(producer_, n_); }
+   iterator end() const { return iterator(); }
+
+private:
+   size_type n_;
+   Producer producer_;
+};
+
+template<typename Producer>
+lazy_sequence<std::decay_t<Producer>> makeLazySequence(std::size_t n, Producer&& producer)
+{
+   return lazy_sequence<std::decay_t<Producer>>(n, std::forward<Producer>(producer));
+}
+
+#if defined(__cpp_impl_coroutine) && defined(__cpp_lib_coroutine)
+
+// C++20: a coroutine returning generator<T> produces its elements with co_yield
+// and is suspended between them, so only the requested prefix is ever computed.
+template<typename T>
+class generator {
+public:
+   struct promise_type {
+      const T* current = nullptr;
+      std::exception_ptr error;
+
+      generator get_return_object()
+      { return generator(std::coroutine_handle<promise_type>::from_promise(*this)); }
+      std::suspend_always initial_suspend() noexcept { return {}; }
+      std::suspend_always final_suspend() noexcept { return {}; }
+      std::suspend_always yield_value(const T& value) noexcept
+      {
+         current = std::addressof(value);
+         return {};
+      }
+      void return_void() noexcept {}
+      void unhandled_exception() { error = std::current_exception(); }
+   };
+
+   class iterator {
+   public:
+      using iterator_category = std::input_iterator_tag;
+      using value_type = T;
+      using difference_type = std::ptrdiff_t;
+      using pointer = const T*;
+      using reference = const T&;
+
+      iterator() = default;
+      explicit iterator(std::coroutine_handle<promise_type> h) : h_(h) {}
+
+      reference operator*() const { return *h_.promise().current; }
+      pointer operator->() const { return h_.promise().current; }
+
+      iterator& operator++()
+      {
+         h_.resume();
+         rethrowIfFailed();
+         if (h_.done()) h_ = nullptr;
+         return *this;
+      }
+      void operator++(int) { ++*this; }
+
+      friend bool operator==(const iterator& a, const iterator& b) { return a.h_ == b.h_; }
+      friend bool operator!=(const iterator& a, const iterator& b) { return a.h_ != b.h_; }
+
+   private:
+      friend class generator;
+      void rethrowIfFailed()
+      {
+         if (h_.promise().error) std::rethrow_exception(h_.promise().error);
+      }
+
+      std::coroutine_handle<promise_type> h_ = nullptr;
+   };
+
+   generator(generator&& other) noexcept : h_(std::exchange(other.h_, nullptr)) {}
+   generator& operator=(generator&& other) noexcept
+   {
+      if (this != &other) {
+         if (h_) h_.destroy();
+         h_ = std::exchange(other.h_, nullptr);
+      }
+      return *this;
+   }
+   generator(const generator&) = delete;
+   generator& operator=(const generator&) = delete;
+   ~generator() { if (h_) h_.destroy(); }
+
+   // may be called once: the coroutine is resumed up to its first co_yield
+   iterator begin()
+   {
+      iterator it(h_);
+      ++it;
+      return it;
+   }
+   iterator end() { return iterator(); }
+
+private:
+   explicit generator(std::coroutine_handle<promise_type> h) : h_(h) {}
+
+   std::coroutine_handle<promise_type> h_;
+};
+
+#endif
+
+#endif // LAZY_GENERATOR_H
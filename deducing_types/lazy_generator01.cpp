@@ -0,0 +1,122 @@
+#include <iostream>
+#include <string>
+#include <deque>
+#include <vector>
+#include <chrono>
+#include <utility>
+#include <cstdlib>
+#include <type_traits>
+#include <assert.h>
+
+#include "demo_support.h"
+#include "fast_int_to_string.h"
+#include "lazy_generator.h"
+
+// Producing elements on demand
+//
+// In understand_decltype01.cpp we copy one element out of a temporary container:
+//
+//    auto s = authAndAccess3(makeStringDeque(), 5);
+//
+// makeStringDeque has to build every element before the caller can pick one.
+// With lazy_generator.h the function returns the recipe instead of the result:
+//
+//    auto makeStringSequence(int n) {
+//       return makeLazySequence(n, [](std::size_t i) { return intToString(i + 1); });
+//    }
+//
+// The lambda takes an index, so the sequence is an indexed one and
+// authAndAccess(makeStringSequence(n), 5) computes the sixth string and nothing
+// else, whatever n is. Because lazy_sequence::operator[] returns by value,
+// authAndAccess (whose return type is decltype(std::forward<C>(c)[i])) returns a
+// std::string, so nothing dangles when the temporary sequence goes away.
+//
+// Sequences where each element is derived from the previous one (a running
+// state, a parser, a file being read) cannot jump to element i. They are written
+// as sequential producers, lambdas taking no arguments, and consumed through
+// input iterators. In C++20 the same thing reads more naturally as a coroutine
+// returning generator<std::string>.
+
+std::deque<std::string> makeStringDeque(int n) {
+   std::deque<std::string> res;
+   for (int i = 1; i <= n; ++i)
+      res.push_back(intToString(i));
+   return res;
+}
+
+auto makeStringSequence(int n) {
+   return makeLazySequence(n, [](std::size_t i) { return intToString(i + 1); });
+}
+
+// "1", "12", "123", ... each element extends the previous one
+auto makeGrowingSequence(int n) {
+   return makeLazySequence(n, [s = std::string(), k = 0]() mutable {
+      s += static_cast<char>('0' + (++k % 10));
+      return s;
+   });
+}
+
+#if defined(__cpp_impl_coroutine) && defined(__cpp_lib_coroutine)
+generator<std::string> generateStrings(int first, int last) {
+   char buf[maxDecimalChars<int>()];
+   for (int i = first; i < last; ++i)
+      co_yield std::string(buf, intToChars(buf, i));
+}
+#endif
+
+int main(const int argc, const char* argv[])
+{
+   {
+      auto s = authAndAccess(makeStringSequence(9), 5);
+      static_assert(std::is_same<decltype(s), std::string>::value, "");
+      assert(s == "6");
+
+      auto seq = makeStringSequence(9);
+      std::vector<std::string> all(seq.begin(), seq.end());
+      assert(all.size() == 9 && all.front() == "1" && all.back() == "9");
+      assert(seq.end() - seq.begin() == 9);
+
+      auto grow = makeGrowingSequence(4);
+      std::vector<std::string> prefixes(grow.begin(), grow.end());
+      assert((prefixes == std::vector<std::string>{ "1", "12", "123", "1234" }));
+      assert(grow[2] == "123");   // stepped, not computed directly
+
+#if defined(__cpp_impl_coroutine) && defined(__cpp_lib_coroutine)
+      std::vector<std::string> fromCoroutine;
+      for (const auto& str : generateStrings(1, 10))
+         fromCoroutine.push_back(str);
+      assert(fromCoroutine == all);
+
+      // stop early: the coroutine never runs past the third element
+      int seen = 0;
+      for (const auto& str : generateStrings(0, 1000000000)) {
+         if (++seen == 3) { assert(str == "2"); break; }
+         (void)str;
+      }
+#endif
+   }
+
+   const int n = argc > 1 ? std::atoi(argv[1]) : 1000000;
+   const int k = n / 2;
+
+   std::string fromDeque, fromSequence;
+   double dequeMs = timeIt([&] { fromDeque = authAndAccess(makeStringDeque(n), k); });
+   double sequenceMs = timeIt([&] { fromSequence = authAndAccess(makeStringSequence(n), k); });
+   assert(fromDeque == fromSequence);
+
+   std::cout << "element " << k << " of " << n << ":" << std::endl;
+   std::cout << "authAndAccess(makeStringDeque(n), k):    " << dequeMs << " ms" << std::endl;
+   std::cout << "authAndAccess(makeStringSequence(n), k): " << sequenceMs << " ms" << std::endl;
+
+#if defined(__cpp_impl_coroutine) && defined(__cpp_lib_coroutine)
+   std::size_t chars = 0;
+   double coroutineMs = timeIt([&] {
+      for (const auto& str : generateStrings(0, n))
+         chars += str.size();
+   });
+   std::cout << "full pass over generateStrings(0, n):    " << coroutineMs << " ms ("
+             << chars << " chars)" << std::endl;
+#endif
+
+   return 0;
+}
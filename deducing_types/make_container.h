@@ -0,0 +1,97 @@
+#ifndef MAKE_CONTAINER_H
+#define MAKE_CONTAINER_H
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+// Building containers without std::initializer_list
+//
+// auto_type_deduction01.cpp shows how a braced initializer becomes a
+// std::initializer_list, and templ_func_with_init_list takes one. For
+// containers that is a trap: the elements of a std::initializer_list are
+// const, so a container initialized from one can only copy them.
+//
+//    std::vector<std::string> v{ makeName(1), makeName(2), makeName(3) };
+//
+// builds three temporaries and then copies each one into the vector, an extra
+// allocation and copy per string, although the temporaries are about to die.
+// And with a move-only element type
+//
+//    std::vector<std::unique_ptr<Widget>> w{ std::make_unique<Widget>() };
+//
+// does not compile at all.
+//
+// make_container<C>(args...) takes the elements as universal references and
+// forwards each one into the container: rvalues are moved, lvalues copied,
+// and arguments that are not of the element type are passed to its
+// constructor (emplaced). The container reserves room for all of them first
+// where it can (std::vector and the unordered containers), so it
+// allocates once. Elements go in in argument order through emplace_back,
+// emplace_hint at the end (sets and maps) or emplace_after the last element
+// (std::forward_list).
+//
+// make_container<std::vector>(args...) deduces the element type as the common
+// type of the decayed arguments, as std::vector{ args... } would.
+
+namespace make_container_detail {
+
+template<typename C, typename = void>
+struct has_reserve : std::false_type {};
+
+template<typename C>
+struct has_reserve<C, std::void_t<decltype(std::declval<C&>().reserve(std::size_t()))>>
+   : std::true_type {};
+
+template<typename C, typename = void>
+struct has_emplace_back : std::false_type {};
+
+template<typename C>
+struct has_emplace_back<C, std::void_t<decltype(std::declval<C&>().emplace_back(
+                              std::declval<typename C::value_type>()))>>
+   : std::true_type {};
+
+template<typename C, typename = void>
+struct has_emplace_hint : std::false_type {};
+
+template<typename C>
+struct has_emplace_hint<C, std::void_t<decltype(std::declval<C&>().emplace_hint(
+                              std::declval<C&>().end(), std::declval<typename C::value_type>()))>>
+   : std::true_type {};
+
+template<typename C, typename = void>
+struct has_emplace_after : std::false_type {};
+
+template<typename C>
+struct has_emplace_after<C, std::void_t<decltype(std::declval<C&>().before_begin())>>
+   : std::true_type {};
+
+} // namespace make_container_detail
+
+template<typename C, typename... Args>
+C make_container(Args&&... args)
+{
+   using namespace make_container_detail;
+   C c;
+   if constexpr (has_reserve<C>::value)
+      c.reserve(sizeof...(Args));
+   if constexpr (has_emplace_after<C>::value) {
+      auto last = c.before_begin();
+      ((last = c.emplace_after(last, std::forward<Args>(args))), ...);
+   } else if constexpr (has_emplace_back<C>::value) {
+      (c.emplace_back(std::forward<Args>(args)), ...);
+   } else {
+      static_assert(has_emplace_hint<C>::value,
+                    "make_container needs emplace_back, emplace_hint or emplace_after");
+      (c.emplace_hint(c.end(), std::forward<Args>(args)), ...);
+   }
+   return c;
+}
+
+template<template<typename...> class C, typename... Args>
+C<std::common_type_t<std::decay_t<Args>...>> make_container(Args&&... args)
+{
+   return make_container<C<std::common_type_t<std::decay_t<Args>...>>>(std::forward<Args>(args)...);
+}
+
+#endif // MAKE_CONTAINER_H
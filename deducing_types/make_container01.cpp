@@ -0,0 +1,154 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <list>
+#include <forward_list>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <memory>
+#include <chrono>
+#include <new>
+#include <cstdlib>
+#include <type_traits>
+#include <assert.h>
+
+#include "demo_support.h"
+#include "make_container.h"
+
+// Containers of heavy and move-only elements
+//
+// auto_type_deduction01.cpp: a braced initializer is a std::initializer_list,
+// whose elements are const. make_container (make_container.h) takes the
+// elements as universal references instead, so temporaries are moved into the
+// container and move-only types work.
+//
+// Widget counts its copies and moves. For the benchmark we build a
+// std::vector<std::string> of eight 1 KB strings, all temporaries, many times:
+// from a braced initializer, with make_container, and with push_back without
+// reserve, and count the heap allocations of each with a replaced operator new.
+
+static std::size_t allocations = 0;
+
+// kept out of line: GCC warns about malloc/free pairs once they are inlined
+#if defined(__GNUC__)
+#define OUT_OF_LINE __attribute__((noinline))
+#else
+#define OUT_OF_LINE
+#endif
+
+OUT_OF_LINE void* operator new(std::size_t n)
+{
+   ++allocations;
+   if (void* p = std::malloc(n ? n : 1)) return p;
+   throw std::bad_alloc();
+}
+
+OUT_OF_LINE void operator delete(void* p) noexcept { std::free(p); }
+OUT_OF_LINE void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+struct Widget {
+   static int copies, moves;
+
+   explicit Widget(int a = 0) : a(a) {}
+   Widget(const Widget& w) : a(w.a) { ++copies; }
+   Widget(Widget&& w) noexcept : a(w.a) { ++moves; }
+   Widget& operator=(const Widget&) = default;
+   Widget& operator=(Widget&&) = default;
+
+   int a;
+};
+int Widget::copies = 0;
+int Widget::moves = 0;
+
+std::string makeName(int i)
+{
+   return std::string(1000, static_cast<char>('a' + i % 26));
+}
+
+int main(const int argc, const char* argv[])
+{
+   {
+      std::vector<Widget> braced{ Widget(1), Widget(2), Widget(3) };
+      assert(Widget::copies == 3);                       // one per element
+      Widget::copies = Widget::moves = 0;
+      auto forwarded = make_container<std::vector<Widget>>(Widget(1), Widget(2), Widget(3));
+      assert(Widget::copies == 0 && Widget::moves == 3 && forwarded.capacity() == 3);
+      Widget named(4);
+      auto mixed = make_container<std::vector<Widget>>(named, Widget(5), 6);   // copy, move, emplace
+      assert(Widget::copies == 1 && Widget::moves == 4 && mixed[2].a == 6);
+      (void)braced;
+
+      // std::vector<std::unique_ptr<Widget>> v{ std::make_unique<Widget>(1) };   // error!
+      auto owners = make_container<std::vector<std::unique_ptr<Widget>>>(
+         std::make_unique<Widget>(1), std::make_unique<Widget>(2));
+      assert(owners.size() == 2 && owners[1]->a == 2);
+
+      auto byName = make_container<std::map<std::string, std::unique_ptr<Widget>>>(
+         std::make_pair(std::string("b"), std::make_unique<Widget>(2)),
+         std::make_pair(std::string("a"), std::make_unique<Widget>(1)));
+      assert(byName.begin()->first == "a" && byName.at("b")->a == 2);
+
+      auto ids = make_container<std::set<int>>(3, 1, 2, 3);
+      assert(ids.size() == 3 && *ids.begin() == 1);
+
+      auto ordered = make_container<std::forward_list<int>>(1, 2, 3);
+      assert(ordered.front() == 1 && *std::next(ordered.begin(), 2) == 3);
+
+      auto hashed = make_container<std::unordered_map<int, std::string>>(
+         std::make_pair(1, makeName(1)), std::make_pair(2, makeName(2)));
+      assert(hashed.size() == 2 && hashed.at(2)[0] == 'c');
+
+      auto names = make_container<std::deque>(std::string("Bob"), "Alice");   // std::deque<std::string>
+      static_assert(std::is_same<decltype(names), std::deque<std::string>>::value, "");
+      auto numbers = make_container<std::list>(1, 2.5);                       // std::list<double>
+      static_assert(std::is_same<decltype(numbers), std::list<double>>::value, "");
+      assert(names.back() == "Alice" && numbers.back() == 2.5);
+   }
+
+   const int n = argc > 1 ? std::atoi(argv[1]) : 100000;
+   std::size_t sink = 0;
+
+   std::size_t before = allocations;
+   const double bracedMs = timeIt([&] {
+      for (int i = 0; i < n; ++i) {
+         std::vector<std::string> v{ makeName(i), makeName(i + 1), makeName(i + 2), makeName(i + 3),
+                                     makeName(i + 4), makeName(i + 5), makeName(i + 6), makeName(i + 7) };
+         sink += v.back().size();
+      }
+   });
+   const double bracedAllocs = static_cast<double>(allocations - before) / n;
+
+   before = allocations;
+   const double forwardedMs = timeIt([&] {
+      for (int i = 0; i < n; ++i) {
+         auto v = make_container<std::vector<std::string>>(
+            makeName(i), makeName(i + 1), makeName(i + 2), makeName(i + 3),
+            makeName(i + 4), makeName(i + 5), makeName(i + 6), makeName(i + 7));
+         sink += v.back().size();
+      }
+   });
+   const double forwardedAllocs = static_cast<double>(allocations - before) / n;
+
+   before = allocations;
+   const double pushedMs = timeIt([&] {
+      for (int i = 0; i < n; ++i) {
+         std::vector<std::string> v;
+         for (int k = 0; k < 8; ++k)
+            v.push_back(makeName(i + k));
+         sink += v.back().size();
+      }
+   });
+   const double pushedAllocs = static_cast<double>(allocations - before) / n;
+
+   std::cout << "vector of 8 x 1 KB temporary strings, " << n << " times (" << sink << ")" << std::endl;
+   std::cout << "   braced initializer: " << bracedMs << " ms, " << bracedAllocs
+             << " allocations each" << std::endl;
+   std::cout << "   make_container:     " << forwardedMs << " ms, " << forwardedAllocs
+             << " allocations each" << std::endl;
+   std::cout << "   push_back:          " << pushedMs << " ms, " << pushedAllocs
+             << " allocations each" << std::endl;
+
+   return 0;
+}
@@ -0,0 +1,83 @@
+#ifndef PARAM_PASS_H
+#define PARAM_PASS_H
+
+#include <cstddef>
+#include <type_traits>
+
+// By value or by const&, decided by the type
+//
+// template_type_deduction01.cpp contrasts
+//
+//    template<typename T> void f_copy(T param);
+//    template<typename T> void f_const_ref(const T& param);
+//
+// A generic function has to pick one for every T it will ever see. const T& is
+// the safe choice for std::string, but for an int or a double it is a
+// pessimization: the caller has to store the value to memory to have an address
+// to pass, and the callee loads it back, where by value the value would simply
+// stay in a register. Small structs are the same: the x86-64 System V and
+// AArch64 calling conventions pass a trivially copyable struct of up to 16
+// bytes in registers. And the callee cannot assume that a referenced value is
+// not changed through another pointer, so it may load it again after every
+// store.
+//
+// param_t<T> is T for types that are cheap to copy and passed in registers -
+// trivially copyable, not larger than two pointers - and const T& for
+// everything else:
+//
+//    param_t<int>                       int
+//    param_t<std::complex<double>>      std::complex<double> (16 bytes)
+//    param_t<std::pair<float, float>>   const std::pair<float, float>& (its
+//                                       operator= is user-provided, so it is
+//                                       not trivially copyable)
+//    param_t<std::string>               const std::string&
+//
+// (The Windows x64 convention passes only 1, 2, 4 and 8 byte structs in
+// registers; a 16-byte one is copied by the caller and passed by address,
+// which costs about what const& does.)
+//
+// A parameter of type param_t<T> is a non-deduced context: in
+//
+//    template<typename T> T twice(param_t<T> x);
+//
+// T cannot be deduced from twice(21). param_fn puts a forwarding shim in front
+// of such functions. The implementation is a static member template of a
+// struct with one template parameter per function parameter, in order; the
+// shim deduces each one from the decayed argument type, as f_copy would, and
+// passes the argument on as param_t of it:
+//
+//    struct twice_impl {
+//       template<typename T>
+//       static T call(param_t<T> x) { return x + x; }
+//    };
+//    constexpr param_fn<twice_impl> twice{};
+//
+//    twice(21);                      // twice_impl::call<int>(int)
+//    twice(std::string("ab"));       // twice_impl::call<std::string>(const std::string&)
+//
+// The shim itself is inlined, so what is left is the call to the
+// implementation with each argument passed the cheap way.
+
+// the largest type passed by value
+constexpr std::size_t paramByValueMax = 2 * sizeof(void*);
+
+template<typename T>
+struct pass_by_value
+   : std::integral_constant<bool, std::is_trivially_copyable<T>::value &&
+                                  std::is_trivially_destructible<T>::value &&
+                                  !std::is_array<T>::value &&
+                                  sizeof(T) <= paramByValueMax> {};
+
+template<typename T>
+using param_t = std::conditional_t<pass_by_value<T>::value, T, const T&>;
+
+template<typename Impl>
+struct param_fn {
+   template<typename... Args>
+   constexpr decltype(auto) operator()(Args&&... args) const
+   {
+      return Impl::template call<std::decay_t<Args>...>(args...);
+   }
+};
+
+#endif // PARAM_PASS_H
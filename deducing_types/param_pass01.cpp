@@ -0,0 +1,161 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <complex>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <type_traits>
+#include <assert.h>
+
+#include "demo_support.h"
+#include "param_pass.h"
+
+// f_copy or f_const_ref?
+//
+// template_type_deduction01.cpp declares f_copy(T param) and
+// f_const_ref(const T& param). param_pass.h chooses between them by type:
+// param_t<T>. Here a call-heavy loop
+//
+//    acc = step(acc, xs[i % 1024]);
+//
+// runs with step taking both parameters by const&, by value, and as param_t
+// through a param_fn shim, for an int, a double, a 16-byte struct of a double
+// and an integer, and a 64-byte struct of eight doubles. Each call depends on the result of
+// the previous one, so the time per call is the latency of the call: by const&
+// that includes storing acc to the stack and loading it back in the callee.
+//
+// The step functions must really be called: NOT_INLINED keeps GCC from
+// inlining them, and from rewriting their by-reference parameters into values
+// on its own (-fipa-sra), which it does for functions it can see all callers of.
+
+#if defined(__GNUC__) && !defined(__clang__)
+#define NOT_INLINED __attribute__((noipa))
+#elif defined(__GNUC__) || defined(__clang__)
+#define NOT_INLINED __attribute__((noinline))
+#else
+#define NOT_INLINED
+#endif
+
+// a running mean: one SSE and one integer register
+struct sample {
+   double sum;
+   std::int64_t count;
+};
+
+struct vec8 {
+   double v[8];
+};
+
+inline int combine(int acc, int x) { return ((acc << 1) ^ x) & 0xffffff; }
+inline double combine(double acc, double x) { return acc * 0.5 + x; }
+inline sample combine(const sample& acc, const sample& x) { return { acc.sum * 0.5 + x.sum, acc.count + x.count }; }
+
+inline vec8 combine(const vec8& acc, const vec8& x)
+{
+   vec8 r;
+   for (int i = 0; i < 8; ++i) r.v[i] = acc.v[i] * 0.5 + x.v[i];
+   return r;
+}
+
+inline bool same(int a, int b) { return a == b; }
+inline bool same(double a, double b) { return a == b; }
+inline bool same(const sample& a, const sample& b) { return a.sum == b.sum && a.count == b.count; }
+
+inline bool same(const vec8& a, const vec8& b)
+{
+   for (int i = 0; i < 8; ++i)
+      if (a.v[i] != b.v[i]) return false;
+   return true;
+}
+
+inline double value(int a) { return a; }
+inline double value(double a) { return a; }
+inline double value(const sample& a) { return a.sum + a.count; }
+inline double value(const vec8& a) { return a.v[0] + a.v[7]; }
+
+template<typename T>
+NOT_INLINED T stepByRef(const T& acc, const T& x) { return combine(acc, x); }
+
+template<typename T>
+NOT_INLINED T stepByValue(T acc, T x) { return combine(acc, x); }
+
+struct step_impl {
+   template<typename T, typename U>
+   NOT_INLINED static T call(param_t<T> acc, param_t<U> x) { return combine(acc, x); }
+};
+constexpr param_fn<step_impl> step{};
+
+// how the shim passes an argument of the deduced type
+struct describe_impl {
+   template<typename T>
+   static const char* call(param_t<T>) { return std::is_reference<param_t<T>>::value ? "const&" : "value"; }
+};
+constexpr param_fn<describe_impl> describe{};
+
+// the same loop for every variant, with a local accumulator that only the
+// parameter passing can force to memory; out of line too, so that what is live
+// around it in run does not change how its registers are allocated
+template<typename T, typename Step>
+NOT_INLINED T chain(const std::vector<T>& xs, int calls, Step step)
+{
+   T acc = xs[0];
+   for (int i = 0; i < calls; ++i) acc = step(acc, xs[i & 1023]);
+   return acc;
+}
+
+template<typename T, typename Make>
+void run(const char* name, Make make, int calls)
+{
+   std::vector<T> xs;
+   for (int i = 0; i < 1024; ++i) xs.push_back(make(i));
+
+   T byRef, byValue, byParam;
+   const double refMs = timeIt([&] {
+      byRef = chain(xs, calls, [](const T& acc, const T& x) { return stepByRef<T>(acc, x); });
+   });
+   const double valueMs = timeIt([&] {
+      byValue = chain(xs, calls, [](const T& acc, const T& x) { return stepByValue<T>(acc, x); });
+   });
+   const double paramMs = timeIt([&] {
+      byParam = chain(xs, calls, [](const T& acc, const T& x) { return step(acc, x); });
+   });
+   assert(same(byRef, byValue) && same(byRef, byParam));
+
+   std::cout << name << " (" << sizeof(T) << " bytes, param_t by " << describe(xs[0])
+             << "): const& " << refMs << " ms, value " << valueMs << " ms, param_t "
+             << paramMs << " ms (" << value(byParam) << ")" << std::endl;
+}
+
+int main(const int argc, const char* argv[])
+{
+   static_assert(std::is_same<param_t<int>, int>::value, "");
+   static_assert(std::is_same<param_t<sample>, sample>::value, "");
+   static_assert(std::is_same<param_t<std::complex<double>>, std::complex<double>>::value, "");
+   static_assert(std::is_same<param_t<vec8>, const vec8&>::value, "");
+   static_assert(std::is_same<param_t<std::string>, const std::string&>::value, "");
+   static_assert(std::is_same<param_t<int[4]>, const int (&)[4]>::value, "");
+
+   {
+      const int x = 27;
+      const std::string s = "R. N. Briggs";
+      const char name[] = "R. N. Briggs";
+      assert(std::string(describe(x)) == "value");          // T = int
+      assert(std::string(describe(s)) == "const&");         // T = std::string
+      assert(std::string(describe(name)) == "value");       // T = const char*
+      assert(std::string(describe(std::string())) == "const&");
+      (void)x; (void)name;
+   }
+
+   const int calls = argc > 1 ? std::atoi(argv[1]) : 50000000;
+   run<int>("int", [](int i) { return i; }, calls);
+   run<double>("double", [](int i) { return i * 0.25; }, calls);
+   run<sample>("sample", [](int i) { return sample{ i * 0.25, 1 }; }, calls);
+   run<vec8>("vec8", [](int i) {
+      vec8 v;
+      for (int k = 0; k < 8; ++k) v.v[k] = i + k;
+      return v;
+   }, calls / 5);
+
+   return 0;
+}
@@ -0,0 +1,224 @@
+#ifndef PERFECT_HASH_H
+#define PERFECT_HASH_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+
+// Compile-time perfect hashing (C++17)
+//
+// Given an array of distinct integer keys and a parallel array of values, both
+// known at compile time, makePerfectHashMap builds a table in which every key
+// has its own slot. The construction is the "hash and displace" scheme:
+//
+// 1. every key is scrambled once with a bijective 64-bit mixer, h = mix(key)
+// 2. the low bits of h choose one of `buckets` buckets (about two keys each)
+// 3. each bucket gets its own seed, chosen at compile time such that
+//
+//       slot = ((h ^ seed[bucket]) * golden) >> (64 - slotBits)
+//
+//    sends every key of the bucket to a slot nobody else occupies yet. Buckets
+//    are placed largest first, while the table is still mostly empty.
+//
+// A lookup is therefore: one mix, a mask, one load of the seed, an xor, a
+// multiply and a shift, one load of the stored key and a compare. The compare
+// selects between the stored value and the caller's default by indexing, so
+// there is no branch. Unused slots are filled with a copy of the first
+// key/value pair: a key that lands there either is that first key, and then the
+// stored value is correct anyway, or it does not compare equal.
+//
+// Everything is computed by constexpr functions, so the finished map is a
+// constant in read-only data and there is nothing to initialize at startup.
+// Duplicate keys, or a key set for which no seeds are found, turn the
+// initialization into a compile error.
+
+namespace perfect_hash_detail {
+
+constexpr std::uint64_t mix(std::uint64_t x) noexcept
+{
+   x ^= x >> 33;
+   x *= 0xff51afd7ed558ccdULL;
+   x ^= x >> 33;
+   x *= 0xc4ceb9fe1a85ec53ULL;
+   x ^= x >> 33;
+   return x;
+}
+
+constexpr std::uint64_t golden = 0x9e3779b97f4a7c15ULL;
+
+constexpr std::size_t log2Ceil(std::size_t n) noexcept
+{
+   std::size_t bits = 0;
+   while ((std::size_t(1) << bits) < n) ++bits;
+   return bits;
+}
+
+// slots: a power of two with load factor at most 0.8, and never fewer than 2
+constexpr std::size_t slotBits(std::size_t n) noexcept
+{
+   const std::size_t bits = log2Ceil(n + n / 4 + 1);
+   return bits == 0 ? 1 : bits;
+}
+
+// buckets: a power of two holding about two keys each
+constexpr std::size_t bucketBits(std::size_t n) noexcept
+{
+   return log2Ceil(n / 2 + 1);
+}
+
+template<typename K>
+constexpr std::uint64_t keyBits(K key) noexcept
+{
+   static_assert(std::is_integral<K>::value || std::is_enum<K>::value,
+                 "perfect_hash_map requires integral or enum keys");
+   return static_cast<std::uint64_t>(key);
+}
+
+} // namespace perfect_hash_detail
+
+template<typename K, typename V, std::size_t N>
+class perfect_hash_map {
+public:
+   static constexpr std::size_t slotBits = perfect_hash_detail::slotBits(N);
+   static constexpr std::size_t bucketBits = perfect_hash_detail::bucketBits(N);
+   static constexpr std::size_t slots = std::size_t(1) << slotBits;
+   static constexpr std::size_t buckets = std::size_t(1) << bucketBits;
+
+   constexpr std::size_t size() const noexcept { return N; }
+
+   constexpr std::size_t slotOf(K key) const noexcept
+   {
+      const std::uint64_t h = perfect_hash_detail::mix(perfect_hash_detail::keyBits(key));
+      return slotFor(h, seeds_[h & (buckets - 1)]);
+   }
+
+   constexpr bool contains(K key) const noexcept
+   {
+      return keys_[slotOf(key)] == key;
+   }
+
+   // value for key, or notFound if key is not in the map
+   constexpr V get(K key, V notFound) const noexcept
+   {
+      // pick the result by indexing rather than with ?:, which compilers
+      // happily turn back into a (badly predicted) branch
+      const std::size_t s = slotOf(key);
+      const V* candidates[2] = { &notFound, &values_[s] };
+      return *candidates[keys_[s] == key];
+   }
+
+   // value for key, which must be in the map
+   constexpr const V& operator[](K key) const noexcept
+   {
+      return values_[slotOf(key)];
+   }
+
+   template<typename K2, typename V2, std::size_t N2>
+   friend constexpr perfect_hash_map<K2, V2, N2>
+   makePerfectHashMap(const K2 (&keys)[N2], const V2 (&values)[N2]);
+
+private:
+   static constexpr std::size_t slotFor(std::uint64_t h, std::uint64_t seed) noexcept
+   {
+      return static_cast<std::size_t>(((h ^ seed) * perfect_hash_detail::golden) >>
+                                      (64 - slotBits));
+   }
+
+   std::array<std::uint64_t, buckets> seeds_{};
+   std::array<K, slots> keys_{};
+   std::array<V, slots> values_{};
+};
+
+template<typename K, typename V, std::size_t N>
+constexpr perfect_hash_map<K, V, N>
+makePerfectHashMap(const K (&keys)[N], const V (&values)[N])
+{
+   static_assert(N > 0, "makePerfectHashMap needs at least one key");
+   using Map = perfect_hash_map<K, V, N>;
+   using perfect_hash_detail::mix;
+   using perfect_hash_detail::keyBits;
+
+   for (std::size_t i = 0; i < N; ++i)
+      for (std::size_t j = i + 1; j < N; ++j)
+         if (keys[i] == keys[j])
+            throw std::logic_error("makePerfectHashMap: duplicate key");
+
+   // group keys by bucket (counting sort into members)
+   std::array<std::uint64_t, N> hashes{};
+   std::array<std::size_t, Map::buckets + 1> first{};
+   for (std::size_t i = 0; i < N; ++i) {
+      hashes[i] = mix(keyBits(keys[i]));
+      ++first[(hashes[i] & (Map::buckets - 1)) + 1];
+   }
+   for (std::size_t b = 0; b < Map::buckets; ++b)
+      first[b + 1] += first[b];
+   std::array<std::size_t, N> members{};
+   std::array<std::size_t, Map::buckets> fill{};
+   for (std::size_t i = 0; i < N; ++i) {
+      const std::size_t b = hashes[i] & (Map::buckets - 1);
+      members[first[b] + fill[b]++] = i;
+   }
+
+   // place buckets largest first
+   std::array<std::size_t, Map::buckets> order{};
+   for (std::size_t b = 0; b < Map::buckets; ++b) {
+      std::size_t pos = b;
+      while (pos > 0 && fill[order[pos - 1]] < fill[b]) {
+         order[pos] = order[pos - 1];
+         --pos;
+      }
+      order[pos] = b;
+   }
+
+   Map map;
+   std::array<bool, Map::slots> used{};
+   for (std::size_t o = 0; o < Map::buckets && fill[order[o]] > 0; ++o) {
+      const std::size_t b = order[o];
+      std::uint64_t seed = 0;
+      for (std::size_t attempt = 0;; ++attempt) {
+         if (attempt == (std::size_t(1) << 20))
+            throw std::logic_error("makePerfectHashMap: no seed found");
+         seed = mix(attempt + 1);
+         bool ok = true;
+         for (std::size_t m = first[b]; ok && m < first[b + 1]; ++m) {
+            const std::size_t s = Map::slotFor(hashes[members[m]], seed);
+            if (used[s]) ok = false;
+            for (std::size_t m2 = first[b]; ok && m2 < m; ++m2)
+               if (Map::slotFor(hashes[members[m2]], seed) == s) ok = false;
+         }
+         if (ok) break;
+      }
+      map.seeds_[b] = seed;
+      for (std::size_t m = first[b]; m < first[b + 1]; ++m) {
+         const std::size_t s = Map::slotFor(hashes[members[m]], seed);
+         used[s] = true;
+         map.keys_[s] = keys[members[m]];
+         map.values_[s] = values[members[m]];
+      }
+   }
+
+   for (std::size_t s = 0; s < Map::slots; ++s) {
+      if (!used[s]) {
+         map.keys_[s] = keys[0];
+         map.values_[s] = values[0];
+      }
+   }
+   return map;
+}
+
+template<typename K, typename V, std::size_t N>
+constexpr perfect_hash_map<K, V, N>
+makePerfectHashMap(const std::array<K, N>& keys, const std::array<V, N>& values)
+{
+   K k[N]{};
+   V v[N]{};
+   for (std::size_t i = 0; i < N; ++i) {
+      k[i] = keys[i];
+      v[i] = values[i];
+   }
+   return makePerfectHashMap(k, v);
+}
+
+#endif // PERFECT_HASH_H
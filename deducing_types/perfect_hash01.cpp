@@ -0,0 +1,106 @@
+#include <iostream>
+#include <array>
+#include <unordered_map>
+#include <vector>
+#include <chrono>
+#include <utility>
+#include <cstdint>
+#include <cstdlib>
+#include <assert.h>
+
+#include "demo_support.h"
+#include "perfect_hash.h"
+
+// Linking keyVals to mappedVals at compile time
+//
+// template_type_deduction02.cpp uses arraySize to give mappedVals as many
+// elements as keyVals:
+//
+//    int keyVals[] = { 1, 3, 7, 9, 11, 22, 35 };
+//    int mappedVals[arraySize(keyVals)];
+//
+// The sizes agree, but nothing says that mappedVals[i] belongs to keyVals[i]
+// when we later want to look a key up. If both arrays are constexpr,
+// makePerfectHashMap (perfect_hash.h) can build a collision-free table from them
+// during compilation. Because the two parameters are references to arrays of
+// the same N, arrays of different sizes do not even compile, which is the same
+// guarantee arraySize gave us.
+//
+// The lookups below are checked with static_assert, i.e. by the compiler, and
+// the map itself lives in read-only data. The run-time part compares lookups in
+// a 1000-key perfect hash map with std::unordered_map.
+
+constexpr int keyVals[] = { 1, 3, 7, 9, 11, 22, 35 };
+constexpr int mappedVals[arraySize(keyVals)] = { 10, 30, 70, 90, 110, 220, 350 };
+
+constexpr auto keyToMapped = makePerfectHashMap(keyVals, mappedVals);
+
+static_assert(keyToMapped[9] == 90, "");
+static_assert(keyToMapped.get(35, -1) == 350, "");
+static_assert(keyToMapped.get(2, -1) == -1, "");
+static_assert(!keyToMapped.contains(0), "");
+
+constexpr std::size_t benchKeys = 1000;
+
+constexpr std::array<std::uint32_t, benchKeys> makeBenchKeys()
+{
+   std::array<std::uint32_t, benchKeys> keys{};
+   for (std::size_t i = 0; i < benchKeys; ++i)
+      keys[i] = static_cast<std::uint32_t>(i * 7919 + 13);   // distinct, spread out
+   return keys;
+}
+
+constexpr std::array<std::uint32_t, benchKeys> makeBenchValues()
+{
+   std::array<std::uint32_t, benchKeys> values{};
+   for (std::size_t i = 0; i < benchKeys; ++i)
+      values[i] = static_cast<std::uint32_t>(i);
+   return values;
+}
+
+constexpr auto benchMap = makePerfectHashMap(makeBenchKeys(), makeBenchValues());
+
+int main(const int argc, const char* argv[])
+{
+   for (std::size_t i = 0; i < arraySize(keyVals); ++i)
+      assert(keyToMapped[keyVals[i]] == mappedVals[i]);
+
+   const auto keys = makeBenchKeys();
+   std::unordered_map<std::uint32_t, std::uint32_t> hashMap;
+   for (std::size_t i = 0; i < benchKeys; ++i) {
+      hashMap.emplace(keys[i], static_cast<std::uint32_t>(i));
+      assert(benchMap[keys[i]] == i);
+   }
+   for (std::uint32_t k = 0; k < 100000; ++k)
+      assert(benchMap.contains(k) == (hashMap.count(k) == 1));
+
+   const std::size_t lookups = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 20000000;
+   std::vector<std::uint32_t> queries(lookups);
+   std::uint64_t state = 88172645463325252ULL;
+   for (auto& q : queries) {
+      state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+      q = (state & 1) ? keys[state % benchKeys] : static_cast<std::uint32_t>(state);
+   }
+
+   std::uint64_t perfectSum = 0, unorderedSum = 0;
+   double perfectMs = timeIt([&] {
+      for (auto q : queries)
+         perfectSum += benchMap.get(q, 0);
+   });
+   double unorderedMs = timeIt([&] {
+      for (auto q : queries) {
+         auto it = hashMap.find(q);
+         unorderedSum += it != hashMap.end() ? it->second : 0;
+      }
+   });
+   assert(perfectSum == unorderedSum);
+
+   std::cout << lookups << " lookups, half of them misses, in " << benchKeys << " keys"
+             << std::endl;
+   std::cout << "perfect_hash_map:   " << perfectMs << " ms" << std::endl;
+   std::cout << "std::unordered_map: " << unorderedMs << " ms" << std::endl;
+   std::cout << "table: " << benchMap.slots << " slots, " << benchMap.buckets << " buckets"
+             << " (checksum " << perfectSum << ")" << std::endl;
+
+   return 0;
+}
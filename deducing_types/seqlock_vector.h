@@ -0,0 +1,175 @@
+#ifndef SEQLOCK_VECTOR_H
+#define SEQLOCK_VECTOR_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+
+// Read-mostly containers without reader writes
+//
+// A container read by many threads and written rarely is often guarded by a
+// std::shared_mutex. Taking a shared lock still writes to the mutex (the reader
+// count), so every reader on every core pulls the same cache line into its own
+// cache in exclusive state, and readers end up serialized on that line even
+// though they never conflict with each other.
+//
+// A sequence lock avoids writes on the read side entirely. The writer makes a
+// counter odd, changes the data and makes the counter even again. A reader
+// remembers the counter, copies the element, and checks that the counter is
+// still the same even value; if not, it was overlapped by a write and simply
+// tries again. Readers only ever load shared cache lines, so they scale with
+// the number of cores.
+//
+// The price is that a reader may copy a half-written element before it notices
+// the conflict, so elements must be trivially copyable and are returned by
+// value, never by reference. They must be default constructible too: load
+// copies the words into a T it creates first. To keep that copy free of data
+// races in the C++ memory model, elements are stored as arrays of relaxed
+// std::atomic words.
+//
+// seqlock_vector uses one sequence counter per stripe of stripeSize elements,
+// each counter on its own cache line, so a write only makes the readers of its
+// own stripe retry. Writers are serialized by a mutex; they are rare by
+// assumption. A reader that has to wait for one spins with a pause hint, which
+// frees the core's resources for its sibling hyperthread, and yields its time
+// slice once the wait gets long, in case the writer is waiting for the CPU.
+//
+// Since operator[] returns a copy, authAndAccess(v, i) from
+// understand_decltype01.cpp returns a T for a seqlock_vector, which is exactly
+// the snapshot semantics a concurrent reader needs.
+
+namespace seqlock_vector_detail {
+
+// one step of a spin-wait loop
+inline void pause() noexcept
+{
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+   _mm_pause();
+#elif defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__))
+   __asm__ __volatile__("yield");
+#endif
+}
+
+} // namespace seqlock_vector_detail
+
+template<typename T, std::size_t stripeSize = 64>
+class seqlock_vector {
+   static_assert(std::is_trivially_copyable<T>::value,
+                 "seqlock_vector elements are copied while they may be written");
+   static_assert(std::is_default_constructible<T>::value,
+                 "seqlock_vector elements are read into a default constructed T");
+   static_assert(stripeSize > 0, "stripeSize must be positive");
+
+   using Word = std::uint64_t;
+   static constexpr std::size_t wordsPerElement = (sizeof(T) + sizeof(Word) - 1) / sizeof(Word);
+
+   struct alignas(64) Sequence {
+      std::atomic<std::uint64_t> value{ 0 };
+   };
+
+public:
+   using value_type = T;
+   using size_type = std::size_t;
+
+   explicit seqlock_vector(size_type n, const T& init = T())
+      : n_(n),
+        words_(new std::atomic<Word>[n * wordsPerElement]),
+        sequences_(new Sequence[(n + stripeSize - 1) / stripeSize + 1])
+   {
+      for (size_type i = 0; i < n; ++i)
+         writeWords(i, init);
+   }
+
+   size_type size() const noexcept { return n_; }
+
+   // a consistent copy of element i; retries while a writer is active
+   T load(size_type i) const noexcept
+   {
+      const std::atomic<std::uint64_t>& seq = sequences_[i / stripeSize].value;
+      T result;
+      for (unsigned spins = 0;; ++spins) {
+         const std::uint64_t before = seq.load(std::memory_order_acquire);
+         if (!(before & 1)) {                           // no write in progress
+            readWords(i, result);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq.load(std::memory_order_relaxed) == before)
+               return result;
+         }
+         if (spins < 64)
+            seqlock_vector_detail::pause();
+         else
+            std::this_thread::yield();
+      }
+   }
+
+   T operator[](size_type i) const noexcept { return load(i); }
+
+   void store(size_type i, const T& value)
+   {
+      std::lock_guard<std::mutex> lock(writer_);
+      beginWrite(i);
+      writeWords(i, value);
+      endWrite(i);
+   }
+
+   // read-modify-write of element i: f receives a T& to modify
+   template<typename F>
+   void update(size_type i, F&& f)
+   {
+      std::lock_guard<std::mutex> lock(writer_);
+      T value;
+      readWords(i, value);            // writers are serialized: no retry needed
+      std::forward<F>(f)(value);
+      beginWrite(i);
+      writeWords(i, value);
+      endWrite(i);
+   }
+
+private:
+   void beginWrite(size_type i) noexcept
+   {
+      std::atomic<std::uint64_t>& seq = sequences_[i / stripeSize].value;
+      seq.store(seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+   }
+
+   void endWrite(size_type i) noexcept
+   {
+      std::atomic<std::uint64_t>& seq = sequences_[i / stripeSize].value;
+      seq.store(seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+   }
+
+   void readWords(size_type i, T& out) const noexcept
+   {
+      Word buf[wordsPerElement];
+      const std::atomic<Word>* src = words_.get() + i * wordsPerElement;
+      for (std::size_t w = 0; w < wordsPerElement; ++w)
+         buf[w] = src[w].load(std::memory_order_relaxed);
+      std::memcpy(&out, buf, sizeof(T));
+   }
+
+   void writeWords(size_type i, const T& value) noexcept
+   {
+      Word buf[wordsPerElement] = {};
+      std::memcpy(buf, &value, sizeof(T));
+      std::atomic<Word>* dst = words_.get() + i * wordsPerElement;
+      for (std::size_t w = 0; w < wordsPerElement; ++w)
+         dst[w].store(buf[w], std::memory_order_relaxed);
+   }
+
+   size_type n_;
+   std::unique_ptr<std::atomic<Word>[]> words_;
+   std::unique_ptr<Sequence[]> sequences_;
+   std::mutex writer_;
+};
+
+#endif // SEQLOCK_VECTOR_H
@@ -0,0 +1,132 @@
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <chrono>
+#include <utility>
+#include <cstdint>
+#include <cstdlib>
+#include <type_traits>
+#include <assert.h>
+
+#include "demo_support.h"
+#include "seqlock_vector.h"
+
+// Many readers, one rare writer
+//
+// The containers we reach through authAndAccess are read by many threads and
+// updated now and then. Guarding them with a std::shared_mutex means every read
+// writes the mutex's reader count; seqlock_vector (seqlock_vector.h) lets readers
+// detect an overlapping write and retry instead, without writing anything.
+//
+// The benchmark starts `readers` threads (64 by default) that read random
+// elements, and one writer that keeps updating random elements, for both a
+// std::shared_mutex protected std::vector and a seqlock_vector. Every element
+// keeps the invariant ask == bid + 1 and version == bid * 2, so a torn read would
+// be detected by the readers.
+
+struct Quote {
+   double bid;
+   double ask;
+   std::uint64_t version;
+};
+
+Quote makeQuote(std::uint64_t v) {
+   return Quote{ static_cast<double>(v), static_cast<double>(v) + 1, v * 2 };
+}
+
+bool consistent(const Quote& q) {
+   return q.ask == q.bid + 1 && q.version == static_cast<std::uint64_t>(q.bid) * 2;
+}
+
+class SharedMutexQuotes {
+public:
+   explicit SharedMutexQuotes(std::size_t n) : quotes_(n, makeQuote(0)) {}
+
+   Quote operator[](std::size_t i) const {
+      std::shared_lock<std::shared_mutex> lock(mutex_);
+      return quotes_[i];
+   }
+
+   void store(std::size_t i, const Quote& q) {
+      std::unique_lock<std::shared_mutex> lock(mutex_);
+      quotes_[i] = q;
+   }
+
+   std::size_t size() const { return quotes_.size(); }
+
+private:
+   mutable std::shared_mutex mutex_;
+   std::vector<Quote> quotes_;
+};
+
+template<typename Quotes>
+double readsPerSecond(Quotes& quotes, int readers, std::size_t readsPerThread)
+{
+   std::atomic<bool> stop{ false };
+   std::atomic<int> torn{ 0 };
+
+   std::thread writer([&] {
+      std::uint64_t state = 0x9e3779b97f4a7c15ULL, v = 1;
+      while (!stop.load(std::memory_order_relaxed)) {
+         state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+         quotes.store(state % quotes.size(), makeQuote(v++));
+         std::this_thread::sleep_for(std::chrono::microseconds(50));
+      }
+   });
+
+   auto start = std::chrono::steady_clock::now();
+   std::vector<std::thread> threads;
+   for (int t = 0; t < readers; ++t) {
+      threads.emplace_back([&, t] {
+         std::uint64_t state = 88172645463325252ULL + t;
+         int bad = 0;
+         for (std::size_t r = 0; r < readsPerThread; ++r) {
+            state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+            Quote q = authAndAccess(quotes, state % quotes.size());
+            bad += !consistent(q);
+         }
+         torn += bad;
+      });
+   }
+   for (auto& th : threads)
+      th.join();
+   std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+   stop = true;
+   writer.join();
+   assert(torn == 0);
+   return readers * static_cast<double>(readsPerThread) / elapsed.count();
+}
+
+int main(const int argc, const char* argv[])
+{
+   {
+      seqlock_vector<Quote> quotes(10, makeQuote(0));
+      static_assert(std::is_same<decltype(authAndAccess(quotes, 3)), Quote>::value,
+                    "readers get snapshots, not references");
+      quotes.store(3, makeQuote(7));
+      quotes.update(3, [](Quote& q) { q = makeQuote(static_cast<std::uint64_t>(q.bid) + 1); });
+      assert(authAndAccess(quotes, 3).version == 16);
+      assert(consistent(quotes[9]));
+   }
+
+   const int readers = argc > 1 ? std::atoi(argv[1]) : 64;
+   const std::size_t reads = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 200000;
+   const std::size_t elements = 4096;
+
+   SharedMutexQuotes locked(elements);
+   seqlock_vector<Quote> sequenced(elements, makeQuote(0));
+
+   double lockedRate = readsPerSecond(locked, readers, reads);
+   double sequencedRate = readsPerSecond(sequenced, readers, reads);
+
+   std::cout << readers << " reader threads, " << std::thread::hardware_concurrency()
+             << " hardware threads" << std::endl;
+   std::cout << "std::shared_mutex: " << lockedRate / 1e6 << " M reads/s" << std::endl;
+   std::cout << "seqlock_vector:    " << sequencedRate / 1e6 << " M reads/s" << std::endl;
+
+   return 0;
+}
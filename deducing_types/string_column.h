@@ -0,0 +1,278 @@
+#ifndef STRING_COLUMN_H
+#define STRING_COLUMN_H
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "fast_int_to_string.h"
+
+// string_column: many strings, two allocations
+//
+// A std::deque<std::string> such as the one makeStringDeque returns stores each
+// element as a separate std::string object inside deque blocks of a few hundred
+// bytes; any string longer than the SSO capacity owns yet another heap block.
+// Walking it touches the deque's block map, the string headers and, for long
+// strings, a pointer per element.
+//
+// string_column keeps all characters back to back in a single growing buffer
+// and records where each string starts in an offsets array. offsets_ always
+// holds size() + 1 entries, the first being 0, so string i is simply
+//
+//    chars_[offsets_[i], offsets_[i+1])
+//
+// and operator[] needs no branch. Elements are handed out as std::string_view.
+// Because a view into a temporary column would dangle, operator[] is overloaded
+// on the value category of the column, in the same way that authAndAccess5 in
+// understand_decltype01.cpp relies on: an lvalue column yields a
+// std::string_view, an rvalue column yields an owning std::string. That keeps
+//
+//    auto s = authAndAccess(makeStringColumn(), 5);
+//
+// safe, while authAndAccess(column, 5) on a named column costs nothing.
+
+class string_column {
+public:
+   using value_type = std::string_view;
+   using size_type = std::size_t;
+   using difference_type = std::ptrdiff_t;
+
+   class const_iterator {
+   public:
+      using iterator_category = std::random_access_iterator_tag;
+      using value_type = std::string_view;
+      using difference_type = std::ptrdiff_t;
+      using pointer = void;
+      using reference = std::string_view;
+
+      const_iterator() = default;
+
+      std::string_view operator*() const noexcept
+      { return std::string_view(chars_ + off_[0], off_[1] - off_[0]); }
+      std::string_view operator[](difference_type n) const noexcept
+      { return *(*this + n); }
+
+      const_iterator& operator++() noexcept { ++off_; return *this; }
+      const_iterator operator++(int) noexcept { const_iterator t = *this; ++off_; return t; }
+      const_iterator& operator--() noexcept { --off_; return *this; }
+      const_iterator operator--(int) noexcept { const_iterator t = *this; --off_; return t; }
+      const_iterator& operator+=(difference_type n) noexcept { off_ += n; return *this; }
+      const_iterator& operator-=(difference_type n) noexcept { off_ -= n; return *this; }
+      friend const_iterator operator+(const_iterator it, difference_type n) noexcept
+      { return it += n; }
+      friend const_iterator operator+(difference_type n, const_iterator it) noexcept
+      { return it += n; }
+      friend const_iterator operator-(const_iterator it, difference_type n) noexcept
+      { return it -= n; }
+      friend difference_type operator-(const const_iterator& a, const const_iterator& b) noexcept
+      { return a.off_ - b.off_; }
+
+      friend bool operator==(const const_iterator& a, const const_iterator& b) noexcept
+      { return a.off_ == b.off_; }
+      friend bool operator!=(const const_iterator& a, const const_iterator& b) noexcept
+      { return a.off_ != b.off_; }
+      friend bool operator<(const const_iterator& a, const const_iterator& b) noexcept
+      { return a.off_ < b.off_; }
+      friend bool operator>(const const_iterator& a, const const_iterator& b) noexcept
+      { return a.off_ > b.off_; }
+      friend bool operator<=(const const_iterator& a, const const_iterator& b) noexcept
+      { return a.off_ <= b.off_; }
+      friend bool operator>=(const const_iterator& a, const const_iterator& b) noexcept
+      { return a.off_ >= b.off_; }
+
+   private:
+      friend class string_column;
+      const_iterator(const char* chars, const size_type* off) noexcept
+         : chars_(chars), off_(off) {}
+
+      const char* chars_ = nullptr;
+      const size_type* off_ = nullptr;
+   };
+   using iterator = const_iterator;
+
+   string_column() : offsets_(1, 0) {}
+
+   // room for nStrings strings with nChars characters in total
+   void reserve(size_type nStrings, size_type nChars)
+   {
+      offsets_.reserve(nStrings + 1);
+      chars_.reserve(nChars);
+   }
+
+   // s may view one of our own strings: it is then copied by position, since
+   // growing the buffer moves the characters it points to
+   void push_back(std::string_view s)
+   {
+      if (viewsOwnChars(s)) {
+         const size_type from = static_cast<size_type>(s.data() - chars_.data());
+         const size_type old = chars_.size();
+         grow(chars_, old + s.size());
+         chars_.resize(old + s.size());
+         std::copy_n(chars_.data() + from, s.size(), chars_.data() + old);
+      } else {
+         chars_.insert(chars_.end(), s.begin(), s.end());
+      }
+      offsets_.push_back(chars_.size());
+   }
+
+   // appends every string in [first, last); for forward iterators the
+   // characters are counted first so each buffer grows at most once.
+   // The strings may view this column's own characters.
+   template<typename It>
+   void append(It first, It last)
+   {
+      appendImpl(first, last,
+                 typename std::iterator_traits<It>::iterator_category());
+   }
+
+   // a range of this very column is appended by index, because growing
+   // offsets_ moves the entries its iterators point to
+   void append(const_iterator first, const_iterator last)
+   {
+      const std::less_equal<const size_type*> notAfter;
+      if (!(notAfter(offsets_.data(), first.off_) &&
+            notAfter(first.off_, offsets_.data() + size()))) {
+         appendImpl(first, last, std::random_access_iterator_tag());
+         return;
+      }
+      const size_type i = static_cast<size_type>(first.off_ - offsets_.data());
+      const size_type n = static_cast<size_type>(last - first);
+      grow(offsets_, offsets_.size() + n);
+      grow(chars_, chars_.size() + (offsets_[i + n] - offsets_[i]));
+      for (size_type k = i; k < i + n; ++k)
+         push_back((*this)[k]);
+   }
+
+   // appends the decimal representation of every integer in [first, last),
+   // written directly into the character buffer
+   template<typename Int>
+   void appendIntRange(Int first, Int last)
+   {
+      if (!(first < last)) return;
+      const size_type oldChars = chars_.size();
+      const size_type nChars = decimalRangeLength(first, last);
+      grow(chars_, oldChars + nChars);
+      grow(offsets_, offsets_.size() + static_cast<size_type>(last - first));
+      chars_.resize(oldChars + nChars);
+      const char* base = chars_.data();
+      writeIntRange(chars_.data() + oldChars, first, last,
+                    [&](const char*, const char* end)
+                    { offsets_.push_back(static_cast<size_type>(end - base)); });
+   }
+
+   std::string_view operator[](size_type i) const& noexcept
+   {
+      return std::string_view(chars_.data() + offsets_[i], offsets_[i + 1] - offsets_[i]);
+   }
+
+   std::string operator[](size_type i) &&
+   {
+      return std::string(static_cast<const string_column&>(*this)[i]);
+   }
+
+   std::string_view at(size_type i) const&
+   {
+      if (i >= size()) throw std::out_of_range("string_column::at");
+      return (*this)[i];
+   }
+
+   std::string at(size_type i) &&
+   {
+      return std::string(static_cast<const string_column&>(*this).at(i));
+   }
+
+   std::string_view front() const& noexcept { return (*this)[0]; }
+   std::string_view back() const& noexcept { return (*this)[size() - 1]; }
+
+   size_type size() const noexcept { return offsets_.size() - 1; }
+   bool empty() const noexcept { return offsets_.size() == 1; }
+
+   // every character of every string, back to back; scanning this is a
+   // single sequential pass over memory
+   std::string_view chars() const noexcept
+   { return std::string_view(chars_.data(), chars_.size()); }
+
+   const size_type* offsets() const noexcept { return offsets_.data(); }
+
+   void clear() noexcept
+   {
+      chars_.clear();
+      offsets_.resize(1);
+   }
+
+   void shrink_to_fit()
+   {
+      chars_.shrink_to_fit();
+      offsets_.shrink_to_fit();
+   }
+
+   const_iterator begin() const noexcept { return const_iterator(chars_.data(), offsets_.data()); }
+   const_iterator end() const noexcept
+   { return const_iterator(chars_.data(), offsets_.data() + size()); }
+   const_iterator cbegin() const noexcept { return begin(); }
+   const_iterator cend() const noexcept { return end(); }
+
+private:
+   template<typename It>
+   void appendImpl(It first, It last, std::input_iterator_tag)
+   {
+      for (; first != last; ++first)
+         push_back(*first);
+   }
+
+   template<typename It>
+   void appendImpl(It first, It last, std::forward_iterator_tag)
+   {
+      size_type nChars = 0, nStrings = 0;
+      bool ownViews = false;
+      for (It it = first; it != last; ++it, ++nStrings) {
+         const std::string_view s(*it);
+         nChars += s.size();
+         ownViews = ownViews || viewsOwnChars(s);
+      }
+      grow(offsets_, offsets_.size() + nStrings);
+      if (ownViews) {
+         // the strings view chars_: fill a new buffer while the old one lives
+         std::vector<char> fresh;
+         fresh.reserve(std::max(2 * chars_.capacity(), chars_.size() + nChars));
+         fresh.assign(chars_.begin(), chars_.end());
+         for (; first != last; ++first) {
+            const std::string_view s(*first);
+            fresh.insert(fresh.end(), s.begin(), s.end());
+            offsets_.push_back(fresh.size());
+         }
+         chars_.swap(fresh);
+         return;
+      }
+      grow(chars_, chars_.size() + nChars);
+      for (; first != last; ++first)
+         push_back(*first);
+   }
+
+   bool viewsOwnChars(std::string_view s) const noexcept
+   {
+      const std::less_equal<const char*> notAfter;
+      return !s.empty() && notAfter(chars_.data(), s.data()) &&
+             notAfter(s.data() + s.size(), chars_.data() + chars_.size());
+   }
+
+   // makes room for needed elements, at least doubling the capacity, so that
+   // many small appends reallocate as rarely as push_back does
+   template<typename V>
+   static void grow(V& v, size_type needed)
+   {
+      if (needed > v.capacity())
+         v.reserve(std::max(2 * v.capacity(), needed));
+   }
+
+   std::vector<char> chars_;
+   std::vector<size_type> offsets_;
+};
+
+#endif // STRING_COLUMN_H
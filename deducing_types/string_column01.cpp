@@ -0,0 +1,116 @@
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <deque>
+#include <vector>
+#include <chrono>
+#include <utility>
+#include <cstdlib>
+#include <type_traits>
+#include <assert.h>
+
+#include "demo_support.h"
+#include "fast_int_to_string.h"
+#include "string_column.h"
+
+// Storing many small strings contiguously
+//
+// makeStringDeque() returns a std::deque<std::string>. For the nine one-digit
+// strings of understand_decltype01.cpp that is harmless, but our real versions
+// hold millions of short strings, and then the layout of the container matters
+// more than anything done with the strings themselves.
+//
+// string_column (string_column.h) stores all characters in one buffer plus an
+// offsets array. Here we build the same sequence of numeric strings both ways
+// and compare construction time, the time to visit every element, and the
+// memory footprint.
+//
+// The column also works with the authAndAccess template from
+// understand_decltype01.cpp. For a named column authAndAccess returns whatever
+// column[i] returns, a std::string_view; for a temporary column operator[] &&
+// yields a std::string, so the element is copied out before the column dies.
+
+std::deque<std::string> makeStringDeque(int n) {
+   std::deque<std::string> res;
+   char buf[maxDecimalChars<int>()];
+   for (int i = 0; i < n; ++i)
+      res.emplace_back(buf, intToChars(buf, i));
+   return res;
+}
+
+string_column makeStringColumn(int n) {
+   string_column res;
+   res.appendIntRange(0, n);
+   return res;
+}
+
+template<typename Container>
+std::size_t checksum(const Container& c)
+{
+   std::size_t sum = 0;
+   for (const auto& s : c)
+      for (char ch : s)
+         sum = sum * 31 + static_cast<unsigned char>(ch);
+   return sum;
+}
+
+int main(const int argc, const char* argv[])
+{
+   const int n = argc > 1 ? std::atoi(argv[1]) : 5000000;
+
+   {
+      string_column col;
+      col.push_back("Mieko");
+      col.push_back("");
+      const std::vector<std::string> names = { "Hanna", "Emily" };
+      col.append(names.begin(), names.end());
+      col.appendIntRange(-2, 2);
+      assert(col.size() == 8);
+      assert(col[0] == "Mieko" && col[1].empty() && col[3] == "Emily");
+      assert(col[4] == "-2" && col[7] == "1");
+      assert(col.chars() == "MiekoHannaEmily-2-101");
+
+      // lvalue column: a view into the column
+      static_assert(std::is_same<decltype(authAndAccess(col, 3)), std::string_view>::value, "");
+      assert(authAndAccess(col, 3) == "Emily");
+
+      // rvalue column: an owning copy of the element
+      static_assert(std::is_same<decltype(authAndAccess(makeStringColumn(10), 5)),
+                                 std::string>::value, "");
+      auto s = authAndAccess(makeStringColumn(10), 5);
+      assert(s == "5");
+
+      // appending the column, or views of it, to itself
+      string_column twice;
+      twice.push_back("ab");
+      twice.push_back("cde");
+      twice.push_back(twice[1]);
+      twice.append(twice.begin(), twice.end());
+      const std::vector<std::string_view> views = { twice[0], twice[2] };
+      twice.append(views.begin(), views.end());
+      assert(twice.size() == 8 && twice.chars() == "abcdecdeabcdecdeabcde");
+   }
+
+   std::deque<std::string> d;
+   string_column col;
+   double dequeBuildMs = timeIt([&] { d = makeStringDeque(n); });
+   double columnBuildMs = timeIt([&] { col = makeStringColumn(n); });
+
+   std::size_t dequeSum = 0, columnSum = 0;
+   double dequeScanMs = timeIt([&] { dequeSum = checksum(d); });
+   double columnScanMs = timeIt([&] { columnSum = checksum(col); });
+   assert(dequeSum == columnSum);
+
+   std::size_t columnBytes = col.chars().size() + (col.size() + 1) * sizeof(std::size_t);
+   std::size_t dequeBytes = d.size() * sizeof(std::string);   // lower bound: headers only
+
+   std::cout << n << " strings" << std::endl;
+   std::cout << "build  deque<string>: " << dequeBuildMs << " ms, string_column: "
+             << columnBuildMs << " ms" << std::endl;
+   std::cout << "scan   deque<string>: " << dequeScanMs << " ms, string_column: "
+             << columnScanMs << " ms" << std::endl;
+   std::cout << "bytes  deque<string>: >= " << dequeBytes << ", string_column: "
+             << columnBytes << std::endl;
+
+   return 0;
+}
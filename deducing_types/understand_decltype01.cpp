@@ -8,6 +8,8 @@
 #include <initializer_list>
 #include <deque>
 
+#include "fast_int_to_string.h"
+
 // Understanding  decltype
 //
 // decltype is an odd creature. Given a name or an expression, decltype
@@ -177,12 +179,10 @@ decltype(auto) myWidget2 = cw;   // decltype type deduction:
 
 std::deque<std::string> makeStringDeque() {
    std::deque<std::string> res;
-   std::stringstream stream;
+   // not a std::stringstream; fast_int_to_string01.cpp explains why
+   char buf[maxDecimalChars<int>()];
    for (int i=1; i<10; ++i) {
-       stream << i;
-       std::string str;
-       stream >> str; 
-       res.push_back(str);
+       res.emplace_back(buf, intToChars(buf, i));
    }
    // init res with something
    return res;
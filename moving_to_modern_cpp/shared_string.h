@@ -0,0 +1,257 @@
+#ifndef SHARED_STRING_H
+#define SHARED_STRING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+// Copy-on-write strings
+//
+// In init_with_braces_and_parentheses01.cpp
+//
+//    Widget w2 = w1;   // not an assignment; calls copy ctor
+//    w1 = w2;          // an assignment; calls copy operator=
+//
+// both copy Widget::b, a std::string, character by character, and allocate as
+// soon as the string outgrows the small string buffer. If widgets are copied
+// far more often than their strings change, most of those copies are wasted.
+//
+// basic_shared_string keeps its characters in a heap block together with a
+// reference count. Copying or assigning a string only bumps the count, so it is
+// O(1) whatever the length. The first mutation of a string whose block is
+// shared with others copies the block first ("detach on write"), so nobody ever
+// observes another string's change.
+//
+// There is deliberately no non-const operator[] and no non-const iterator: a
+// char& handed out from a shared block is exactly how copy-on-write strings go
+// wrong. Changes go through set, append, push_back, assign, clear and
+// mutable_data, all of which detach first.
+//
+// The reference count is a std::atomic by default, which makes copies safe to
+// share between threads. local_shared_string uses a plain counter instead for
+// strings that never leave one thread, where the locked increment is the most
+// expensive part of a copy.
+
+namespace shared_string_detail {
+
+struct AtomicCount {
+   std::atomic<std::size_t> n;
+   explicit AtomicCount(std::size_t v) noexcept : n(v) {}
+   void increment() noexcept { n.fetch_add(1, std::memory_order_relaxed); }
+   // true when this was the last reference
+   bool decrement() noexcept { return n.fetch_sub(1, std::memory_order_acq_rel) == 1; }
+   std::size_t get() const noexcept { return n.load(std::memory_order_acquire); }
+};
+
+struct LocalCount {
+   std::size_t n;
+   explicit LocalCount(std::size_t v) noexcept : n(v) {}
+   void increment() noexcept { ++n; }
+   bool decrement() noexcept { return --n == 0; }
+   std::size_t get() const noexcept { return n; }
+};
+
+} // namespace shared_string_detail
+
+template<bool AtomicCount = true>
+class basic_shared_string {
+   using Count = typename std::conditional<AtomicCount,
+                                           shared_string_detail::AtomicCount,
+                                           shared_string_detail::LocalCount>::type;
+
+   // the characters follow the header in the same allocation
+   struct Rep {
+      Count refs;
+      std::size_t size;
+      std::size_t capacity;
+
+      char* chars() noexcept { return reinterpret_cast<char*>(this + 1); }
+   };
+
+public:
+   using size_type = std::size_t;
+   using value_type = char;
+   using const_iterator = const char*;
+   static constexpr size_type npos = static_cast<size_type>(-1);
+
+   basic_shared_string() noexcept = default;
+   basic_shared_string(const char* s) : basic_shared_string(s, std::strlen(s)) {}
+   basic_shared_string(std::string_view s) : basic_shared_string(s.data(), s.size()) {}
+   basic_shared_string(const std::string& s) : basic_shared_string(s.data(), s.size()) {}
+   basic_shared_string(const char* s, size_type n) : rep_(n ? allocate(n) : nullptr)
+   {
+      if (rep_) {
+         std::memcpy(rep_->chars(), s, n);
+         rep_->size = n;
+         rep_->chars()[n] = '\0';
+      }
+   }
+
+   basic_shared_string(const basic_shared_string& other) noexcept : rep_(other.rep_)
+   {
+      if (rep_) rep_->refs.increment();
+   }
+
+   basic_shared_string(basic_shared_string&& other) noexcept : rep_(other.rep_)
+   {
+      other.rep_ = nullptr;
+   }
+
+   basic_shared_string& operator=(const basic_shared_string& other) noexcept
+   {
+      if (other.rep_) other.rep_->refs.increment();    // first, for self-assignment
+      release();
+      rep_ = other.rep_;
+      return *this;
+   }
+
+   basic_shared_string& operator=(basic_shared_string&& other) noexcept
+   {
+      if (this != &other) {
+         release();
+         rep_ = other.rep_;
+         other.rep_ = nullptr;
+      }
+      return *this;
+   }
+
+   ~basic_shared_string() { release(); }
+
+   // read access never copies
+
+   size_type size() const noexcept { return rep_ ? rep_->size : 0; }
+   size_type length() const noexcept { return size(); }
+   bool empty() const noexcept { return size() == 0; }
+   const char* data() const noexcept { return rep_ ? rep_->chars() : ""; }
+   const char* c_str() const noexcept { return data(); }
+   const char& operator[](size_type i) const noexcept { return data()[i]; }
+   const_iterator begin() const noexcept { return data(); }
+   const_iterator end() const noexcept { return data() + size(); }
+
+   operator std::string_view() const noexcept { return std::string_view(data(), size()); }
+   std::string str() const { return std::string(data(), size()); }
+
+   // number of strings sharing this block (0 for an empty string)
+   size_type use_count() const noexcept { return rep_ ? rep_->refs.get() : 0; }
+
+   // mutation detaches first
+
+   void set(size_type i, char c) { mutable_data()[i] = c; }
+
+   // an empty string gets a block of its own, so the result is always writable
+   // up to size() and never points into a string literal
+   char* mutable_data()
+   {
+      detach(size());
+      return rep_->chars();
+   }
+
+   basic_shared_string& append(std::string_view s)
+   {
+      if (s.empty()) return *this;
+      const size_type old = size();
+      if (ownsRoomFor(old + s.size())) {
+         std::memmove(rep_->chars() + old, s.data(), s.size());
+      } else {
+         // s may be a view of *this: copy it into the new block before the
+         // old one can be freed
+         Rep* fresh = copied(old + s.size());
+         std::memcpy(fresh->chars() + old, s.data(), s.size());
+         release();
+         rep_ = fresh;
+      }
+      rep_->size = old + s.size();
+      rep_->chars()[rep_->size] = '\0';
+      return *this;
+   }
+
+   basic_shared_string& operator+=(std::string_view s) { return append(s); }
+
+   void push_back(char c) { append(std::string_view(&c, 1)); }
+
+   basic_shared_string& assign(std::string_view s)
+   {
+      return *this = basic_shared_string(s);
+   }
+
+   void clear() noexcept { release(); rep_ = nullptr; }
+
+   friend bool operator==(const basic_shared_string& a, const basic_shared_string& b) noexcept
+   {
+      return a.rep_ == b.rep_ || std::string_view(a) == std::string_view(b);
+   }
+   friend bool operator!=(const basic_shared_string& a, const basic_shared_string& b) noexcept
+   { return !(a == b); }
+   friend bool operator<(const basic_shared_string& a, const basic_shared_string& b) noexcept
+   { return std::string_view(a) < std::string_view(b); }
+   friend bool operator==(const basic_shared_string& a, std::string_view b) noexcept
+   { return std::string_view(a) == b; }
+   friend bool operator!=(const basic_shared_string& a, std::string_view b) noexcept
+   { return std::string_view(a) != b; }
+   friend bool operator==(const basic_shared_string& a, const char* b) noexcept
+   { return std::string_view(a) == b; }
+   friend bool operator!=(const basic_shared_string& a, const char* b) noexcept
+   { return std::string_view(a) != b; }
+
+   friend std::ostream& operator<<(std::ostream& os, const basic_shared_string& s)
+   {
+      return os << std::string_view(s);
+   }
+
+private:
+   static Rep* allocate(size_type capacity)
+   {
+      void* p = std::malloc(sizeof(Rep) + capacity + 1);
+      if (!p) throw std::bad_alloc();
+      return new (p) Rep{ Count(1), 0, capacity };
+   }
+
+   // make rep_ a block we own alone, with room for at least `capacity` chars
+   void detach(size_type capacity)
+   {
+      if (ownsRoomFor(capacity))
+         return;
+      Rep* fresh = copied(capacity);
+      release();
+      rep_ = fresh;
+   }
+
+   bool ownsRoomFor(size_type capacity) const noexcept
+   {
+      return rep_ && rep_->refs.get() == 1 && rep_->capacity >= capacity;
+   }
+
+   // a new block holding our characters, with room for at least `capacity`
+   Rep* copied(size_type capacity) const
+   {
+      size_type newCapacity = capacity;
+      if (rep_ && capacity > rep_->capacity)
+         newCapacity = capacity < 2 * rep_->capacity ? 2 * rep_->capacity : capacity;
+      Rep* fresh = allocate(newCapacity);
+      fresh->size = size();
+      std::memcpy(fresh->chars(), data(), size() + 1);
+      return fresh;
+   }
+
+   void release() noexcept
+   {
+      if (rep_ && rep_->refs.decrement()) {
+         rep_->~Rep();
+         std::free(rep_);
+      }
+   }
+
+   Rep* rep_ = nullptr;
+};
+
+using shared_string = basic_shared_string<true>;
+using local_shared_string = basic_shared_string<false>;
+
+#endif // SHARED_STRING_H
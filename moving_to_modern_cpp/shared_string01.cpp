@@ -0,0 +1,114 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <utility>
+#include <cstdlib>
+#include <assert.h>
+
+#include "demo_support.h"
+#include "shared_string.h"
+
+// Cheap Widget copies with a copy-on-write string
+//
+// The Widget of init_with_braces_and_parentheses01.cpp is an aggregate of an
+// int and a std::string:
+//
+//    struct Widget {
+//      int a;
+//      std::string b;
+//    };
+//
+// Its compiler generated copy constructor and copy assignment copy b, which for
+// anything longer than the small string buffer means an allocation and a
+// memcpy. BasicWidget below is the same aggregate with the type of b as a
+// parameter, so we can compare std::string with shared_string (shared_string.h),
+// whose copies just share the characters, and with local_shared_string, which
+// does the same with a non-atomic reference count. Being aggregates, all of
+// them still support brace initialization: Widget{ 1, "some name" }.
+//
+// The workload is copy heavy: a vector of widgets is copied wholesale and its
+// elements are assigned to each other, with a change to b only every
+// `mutateEvery` rounds.
+
+template<typename String>
+struct BasicWidget {
+  int a;
+  String b;
+};
+
+using Widget = BasicWidget<std::string>;
+using SharedWidget = BasicWidget<shared_string>;
+using LocalSharedWidget = BasicWidget<local_shared_string>;
+
+template<typename W>
+std::size_t copyHeavy(std::size_t widgets, int rounds, int mutateEvery)
+{
+   std::vector<W> source;
+   for (std::size_t i = 0; i < widgets; ++i)
+      source.push_back(W{ static_cast<int>(i),
+                          std::string("widget/name/that/outgrows/sso/") + std::to_string(i) });
+
+   std::size_t total = 0;
+   for (int r = 0; r < rounds; ++r) {
+      std::vector<W> copy = source;            // copy ctor for every element
+      for (std::size_t i = 1; i < copy.size(); ++i)
+         copy[i - 1] = copy[i];                // copy operator=
+      if (r % mutateEvery == 0)
+         source[r % widgets].b += "!";         // rare change: detaches one string
+      total += copy.front().b.size();
+   }
+   return total;
+}
+
+int main(const int argc, const char* argv[])
+{
+   {
+      SharedWidget w1{ 1, "a name longer than the small string buffer" };
+      SharedWidget w2 = w1;      // shares the characters
+      assert(w1.b.use_count() == 2 && w1.b.data() == w2.b.data());
+
+      w1 = w2;                   // still shared, still O(1)
+      assert(w1.b.use_count() == 2);
+
+      w2.b.append("!");          // detach on write: w1 is unaffected
+      assert(w1.b == "a name longer than the small string buffer");
+      assert(w2.b == "a name longer than the small string buffer!");
+      assert(w1.b.use_count() == 1 && w2.b.use_count() == 1);
+
+      w2.b.set(0, 'A');
+      assert(w2.b[0] == 'A' && w1.b[0] == 'a');
+
+      LocalSharedWidget w3{ 3, "" };
+      assert(w3.b.empty() && w3.b.use_count() == 0);
+      char* p = w3.b.mutable_data();             // writable, if only the terminator
+      assert(p && *p == '\0' && w3.b.use_count() == 1 && w3.b.empty());
+      (void)p;
+
+      shared_string self("abc");
+      self += self;                              // reads the block append replaces
+      assert(self == "abcabc");
+      self.append(std::string_view(self).substr(3));
+      assert(self == "abcabcabc");
+      shared_string other = self;                // shared: append must detach
+      self += self;
+      assert(self == "abcabcabcabcabcabc" && other == "abcabcabc");
+   }
+
+   const std::size_t widgets = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000;
+   const int rounds = argc > 2 ? std::atoi(argv[2]) : 2000;
+   const int mutateEvery = 100;
+
+   std::size_t s1 = 0, s2 = 0, s3 = 0;
+   double stringMs = timeIt([&] { s1 = copyHeavy<Widget>(widgets, rounds, mutateEvery); });
+   double sharedMs = timeIt([&] { s2 = copyHeavy<SharedWidget>(widgets, rounds, mutateEvery); });
+   double localMs = timeIt([&] { s3 = copyHeavy<LocalSharedWidget>(widgets, rounds, mutateEvery); });
+   assert(s1 == s2 && s2 == s3);
+
+   std::cout << rounds << " rounds of copying " << widgets << " widgets" << std::endl;
+   std::cout << "std::string:         " << stringMs << " ms" << std::endl;
+   std::cout << "shared_string:       " << sharedMs << " ms" << std::endl;
+   std::cout << "local_shared_string: " << localMs << " ms" << std::endl;
+
+   return 0;
+}
@@ -0,0 +1,144 @@
+#ifndef WIDGET_TABLE_H
+#define WIDGET_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "string_column.h"
+
+// Widgets stored by column
+//
+// The aggregate of init_with_braces_and_parentheses01.cpp,
+//
+//    struct Widget {
+//      int a;
+//      std::string b;
+//    };
+//
+// is 40 bytes on a 64-bit libstdc++, of which 4 are a. A scan over the a's of a
+// std::vector<Widget> therefore reads ten times more memory than it uses, and the
+// stride of 40 bytes keeps the compiler from vectorizing it.
+//
+// WidgetTable stores the same records as two columns: a std::vector<int> for
+// a, and a string_column (deducing_types/string_column.h, one character buffer
+// plus offsets) for b. Scans over a are plain loops over contiguous ints written
+// without branches, which the compiler turns into SIMD code.
+//
+// Rows are appended with the same brace syntax as the aggregate itself,
+//
+//    table.push_back({ 1, "x" });
+//
+// and read back as row_view objects: a reference to the int and a
+// std::string_view into the string column. Like every proxy, a row_view is only
+// valid until the table is modified; toWidgetRow copies one out as a WidgetRow,
+// the Widget aggregate under a name that does not clash with the Widgets the
+// chapter sources define for themselves.
+
+struct WidgetRow {
+  int a;
+  std::string b;
+};
+
+class WidgetTable {
+public:
+   using size_type = std::size_t;
+
+   // what push_back accepts: { int, anything convertible to std::string_view }
+   struct row {
+      int a;
+      std::string_view b;
+   };
+
+   struct row_view {
+      int& a;
+      std::string_view b;
+   };
+
+   struct const_row_view {
+      const int& a;
+      std::string_view b;
+   };
+
+   void reserve(size_type rows, size_type chars)
+   {
+      a_.reserve(rows);
+      b_.reserve(rows, chars);
+   }
+
+   void push_back(const row& r)
+   {
+      a_.push_back(r.a);
+      b_.push_back(r.b);
+   }
+
+   row_view operator[](size_type i) noexcept { return row_view{ a_[i], b_[i] }; }
+   const_row_view operator[](size_type i) const noexcept { return const_row_view{ a_[i], b_[i] }; }
+
+   WidgetRow toWidgetRow(size_type i) const { return WidgetRow{ a_[i], std::string(b_[i]) }; }
+
+   size_type size() const noexcept { return a_.size(); }
+   bool empty() const noexcept { return a_.empty(); }
+
+   // the columns themselves
+   const std::vector<int>& a() const noexcept { return a_; }
+   std::vector<int>& a() noexcept { return a_; }
+   const string_column& b() const noexcept { return b_; }
+
+   // column scans
+
+   std::int64_t sumA() const noexcept
+   {
+      const int* p = a_.data();
+      const size_type n = a_.size();
+      std::int64_t sum = 0;
+      for (size_type i = 0; i < n; ++i)
+         sum += p[i];
+      return sum;
+   }
+
+   // number of rows with lo <= a < hi
+   size_type countAInRange(int lo, int hi) const noexcept
+   {
+      const int* p = a_.data();
+      const size_type n = a_.size();
+      size_type total = 0;
+      // chunks keep the 32-bit per-lane counters from overflowing
+      for (size_type chunk = 0; chunk < n; chunk += 0x1000000) {
+         const size_type end = n - chunk < 0x1000000 ? n : chunk + 0x1000000;
+         std::uint32_t count = 0;
+         for (size_type i = chunk; i < end; ++i)
+            count += (p[i] >= lo) & (p[i] < hi);
+         total += count;
+      }
+      return total;
+   }
+
+   // appends to out the indices of rows with lo <= a < hi
+   void selectAInRange(int lo, int hi, std::vector<size_type>& out) const
+   {
+      const int* p = a_.data();
+      const size_type n = a_.size();
+      // matches are collected branchlessly in a small buffer and appended per
+      // block, so out is neither zero-filled nor sized for the worst case
+      constexpr size_type block = 256;
+      size_type buffer[block];
+      for (size_type start = 0; start < n; start += block) {
+         const size_type end = n - start < block ? n : start + block;
+         size_type k = 0;
+         for (size_type i = start; i < end; ++i) {
+            buffer[k] = i;                        // write unconditionally,
+            k += (p[i] >= lo) & (p[i] < hi);      // advance only on a match
+         }
+         out.insert(out.end(), buffer, buffer + k);
+      }
+   }
+
+private:
+   std::vector<int> a_;
+   string_column b_;
+};
+
+#endif // WIDGET_TABLE_H
@@ -0,0 +1,86 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <utility>
+#include <cstdint>
+#include <cstdlib>
+#include <assert.h>
+
+#include "demo_support.h"
+#include "widget_table.h"
+
+// Arrays of structs vs. structs of arrays
+//
+// init_with_braces_and_parentheses01.cpp introduces
+//
+//    struct Widget {
+//      int a;
+//      std::string b;
+//    };
+//
+// and the natural way to keep many of them is a std::vector<Widget>. When most
+// queries only look at a, that layout wastes nearly all of the memory bandwidth
+// on string headers. Here the same data is loaded into a std::vector<WidgetRow>
+// (widget_table.h's name for that aggregate) and into a WidgetTable, and the
+// two are compared on a sum and a range count over a.
+
+int main(const int argc, const char* argv[])
+{
+   {
+      WidgetTable table;
+      table.push_back({ 1, "x" });                    // brace style, like Widget{ 1, "x" }
+      WidgetRow mieko{ 2, "Mieko" };
+      table.push_back({ mieko.a, mieko.b });
+      table.push_back({ -3, std::string("Hanna") });
+      assert(table.size() == 3);
+      assert(table[1].a == 2 && table[1].b == "Mieko");
+
+      table[0].a = 10;                                // row views write through to the column
+      assert(table.a()[0] == 10);
+      WidgetRow w = table.toWidgetRow(2);
+      assert(w.a == -3 && w.b == "Hanna");
+
+      assert(table.sumA() == 9);
+      assert(table.countAInRange(0, 5) == 1);
+      std::vector<std::size_t> rows;
+      table.selectAInRange(-5, 5, rows);
+      assert((rows == std::vector<std::size_t>{ 1, 2 }));
+   }
+
+   const std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 5000000;
+
+   std::vector<WidgetRow> widgets;
+   WidgetTable table;
+   widgets.reserve(n);
+   std::uint64_t state = 88172645463325252ULL;
+   for (std::size_t i = 0; i < n; ++i) {
+      state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+      int a = static_cast<int>(state % 1000);
+      std::string b = "widget-" + std::to_string(i);
+      table.push_back({ a, b });
+      widgets.push_back(WidgetRow{ a, std::move(b) });
+   }
+
+   std::int64_t aosSum = 0, tableSum = 0;
+   std::size_t aosCount = 0, tableCount = 0;
+   double aosSumMs = timeIt([&] {
+      for (const auto& w : widgets)
+         aosSum += w.a;
+   });
+   double tableSumMs = timeIt([&] { tableSum = table.sumA(); });
+   double aosCountMs = timeIt([&] {
+      for (const auto& w : widgets)
+         aosCount += (w.a >= 100) & (w.a < 200);
+   });
+   double tableCountMs = timeIt([&] { tableCount = table.countAInRange(100, 200); });
+   assert(aosSum == tableSum && aosCount == tableCount);
+
+   std::cout << n << " widgets" << std::endl;
+   std::cout << "sum of a:    vector<WidgetRow> " << aosSumMs << " ms, WidgetTable "
+             << tableSumMs << " ms" << std::endl;
+   std::cout << "count of a:  vector<WidgetRow> " << aosCountMs << " ms, WidgetTable "
+             << tableCountMs << " ms" << std::endl;
+
+   return 0;
+}
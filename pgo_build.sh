@@ -0,0 +1,105 @@
+#!/usr/bin/env bash
+#
+# Profile-guided + link-time optimized build of the chapter benchmarks
+#
+#   ./pgo_build.sh [build-root]
+#
+# 1. builds the benchmarks as a plain Release build in <build-root>/release
+# 2. builds them instrumented (EMC_PGO=GENERATE) in <build-root>/pgo and runs
+#    each one once as the training workload
+# 3. merges the profiles (Clang only; GCC reads the .gcda files directly)
+# 4. rebuilds <build-root>/pgo with EMC_PGO=USE and EMC_LTO=ON
+# 5. runs both builds REPEAT times and prints the best wall-clock time of each
+#    benchmark and the speedup
+#
+# CXX selects the compiler (g++ or clang++), LLVM_PROFDATA the llvm-profdata
+# that matches clang++. The whole benchmark is timed, setup included.
+
+set -euo pipefail
+
+SOURCE_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+BUILD_ROOT="$(mkdir -p "${1:-${SOURCE_DIR}/_pgo_build}" && cd "${1:-${SOURCE_DIR}/_pgo_build}" && pwd)"
+REPEAT="${REPEAT:-3}"
+JOBS="$(nproc 2>/dev/null || echo 4)"
+
+# single-process, CPU-bound benchmarks; the scheduler and queue demos measure
+# sleeping and thread hand-off, which a profile does not change
+BENCHMARKS=(
+   deducing_types/fast_int_to_string01
+   deducing_types/string_column01
+   deducing_types/lazy_generator01
+   deducing_types/perfect_hash01
+   deducing_types/eytzinger_search01
+   deducing_types/batch_lookup01
+   deducing_types/seqlock_vector01
+   moving_to_modern_cpp/shared_string01
+   moving_to_modern_cpp/widget_table01
+   universal_references/inline_string01
+   universal_references/latency_histogram01
+   universal_references/work_stealing_pool01
+   auto/string_concat01
+   auto/packed_int_vector01
+   auto/btree01
+)
+
+targets=()
+for b in "${BENCHMARKS[@]}"; do targets+=("$(basename "$b")"); done
+
+# output goes to <dir>.log and is shown only when the build fails
+configure_and_build() {
+   local dir="$1"; shift
+   if ! { cmake -S "${SOURCE_DIR}" -B "${dir}" -DCMAKE_BUILD_TYPE=Release "$@" &&
+          cmake --build "${dir}" -j"${JOBS}" --target "${targets[@]}"; } > "${dir}.log" 2>&1; then
+      cat "${dir}.log"
+      exit 1
+   fi
+}
+
+# best wall-clock milliseconds of REPEAT runs of $1, run from a scratch directory
+best_ms() {
+   local exe="$1" best="" start end ms
+   for ((i = 0; i < REPEAT; ++i)); do
+      start=$(date +%s%N)
+      (cd "${BUILD_ROOT}/scratch" && "${exe}" > /dev/null)
+      end=$(date +%s%N)
+      ms=$(( (end - start) / 1000000 ))
+      if [[ -z "${best}" || ${ms} -lt ${best} ]]; then best=${ms}; fi
+   done
+   echo "${best}"
+}
+
+RELEASE_DIR="${BUILD_ROOT}/release"
+PGO_DIR="${BUILD_ROOT}/pgo"
+PROFILE_DIR="${BUILD_ROOT}/profiles"
+mkdir -p "${BUILD_ROOT}/scratch"
+rm -rf "${PROFILE_DIR}"
+
+echo "== release build"
+configure_and_build "${RELEASE_DIR}" -DEMC_PGO=OFF -DEMC_LTO=OFF
+
+echo "== instrumented build"
+configure_and_build "${PGO_DIR}" -DEMC_PGO=GENERATE -DEMC_LTO=OFF -DEMC_PGO_DATA="${PROFILE_DIR}"
+
+echo "== training"
+for b in "${BENCHMARKS[@]}"; do
+   echo "   ${b}"
+   (cd "${BUILD_ROOT}/scratch" && "${PGO_DIR}/${b}" > /dev/null)
+done
+
+PROFILE="${PROFILE_DIR}"
+if [[ "$(cmake -LA -N "${PGO_DIR}" | grep '^CMAKE_CXX_COMPILER:')" == *clang* ]]; then
+   PROFILE="${PROFILE_DIR}/merged.profdata"
+   "${LLVM_PROFDATA:-llvm-profdata}" merge -output="${PROFILE}" "${PROFILE_DIR}"/*.profraw
+fi
+
+echo "== PGO + LTO build"
+configure_and_build "${PGO_DIR}" -DEMC_PGO=USE -DEMC_LTO=ON -DEMC_PGO_DATA="${PROFILE}"
+
+echo "== best of ${REPEAT} runs"
+printf "%-44s %12s %12s %9s\n" "benchmark" "release ms" "pgo+lto ms" "speedup"
+for b in "${BENCHMARKS[@]}"; do
+   plain=$(best_ms "${RELEASE_DIR}/${b}")
+   tuned=$(best_ms "${PGO_DIR}/${b}")
+   printf "%-44s %12d %12d %8sx\n" "${b}" "${plain}" "${tuned}" \
+          "$(awk -v a="${plain}" -v b="${tuned}" 'BEGIN { printf "%.2f", (b > 0 ? a / b : 0) }')"
+done
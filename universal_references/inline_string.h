@@ -0,0 +1,320 @@
+#ifndef INLINE_STRING_H
+#define INLINE_STRING_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+// Strings with a configurable inline buffer
+//
+// std::string avoids the heap for short strings, but libstdc++ only keeps 15
+// characters inline. Most names we store, in SomeDataStructure::names, as map
+// keys or in Widget::b, are a little longer than that, so nearly every one of
+// them costs an allocation, and every copy another one.
+//
+// basic_inline_string<N> keeps up to N characters (plus the terminating null)
+// inside the object and only goes to the heap beyond that. Pick N to cover the
+// names you actually have: 23, 31 and 63 give objects of 40, 48 and 80 bytes.
+// The interface follows std::string closely enough to be a drop-in replacement
+// for names: construction from and implicit conversion to std::string_view,
+// explicit conversion to std::string, comparison, hashing, append, find,
+// substr, resize and friends.
+//
+// The characters are inline while capacity_ == N; a larger capacity_ means they
+// are in heap_. The union therefore never needs a separate tag.
+
+template<std::size_t N>
+class basic_inline_string {
+public:
+   using value_type = char;
+   using size_type = std::size_t;
+   using difference_type = std::ptrdiff_t;
+   using reference = char&;
+   using const_reference = const char&;
+   using iterator = char*;
+   using const_iterator = const char*;
+   static constexpr size_type npos = static_cast<size_type>(-1);
+   static constexpr size_type inline_capacity = N;
+
+   basic_inline_string() noexcept { inline_[0] = '\0'; }
+   basic_inline_string(const char* s) : basic_inline_string(std::string_view(s)) {}
+   basic_inline_string(const char* s, size_type n) : basic_inline_string(std::string_view(s, n)) {}
+   basic_inline_string(const std::string& s) : basic_inline_string(std::string_view(s)) {}
+   basic_inline_string(std::string_view s) : basic_inline_string() { assign(s); }
+   basic_inline_string(size_type n, char c) : basic_inline_string() { resize(n, c); }
+
+   basic_inline_string(const basic_inline_string& other) : basic_inline_string()
+   {
+      assign(std::string_view(other));
+   }
+
+   basic_inline_string(basic_inline_string&& other) noexcept : basic_inline_string()
+   {
+      steal(other);
+   }
+
+   basic_inline_string& operator=(const basic_inline_string& other)
+   {
+      if (this != &other) assign(std::string_view(other));
+      return *this;
+   }
+
+   basic_inline_string& operator=(basic_inline_string&& other) noexcept
+   {
+      if (this != &other) {
+         freeHeap();
+         steal(other);
+      }
+      return *this;
+   }
+
+   basic_inline_string& operator=(std::string_view s) { return assign(s); }
+   basic_inline_string& operator=(const char* s) { return assign(std::string_view(s)); }
+
+   ~basic_inline_string() { freeHeap(); }
+
+   // capacity
+
+   size_type size() const noexcept { return size_; }
+   size_type length() const noexcept { return size_; }
+   size_type capacity() const noexcept { return capacity_; }
+   bool empty() const noexcept { return size_ == 0; }
+   bool is_inline() const noexcept { return capacity_ == N; }
+
+   void reserve(size_type n)
+   {
+      if (n <= capacity_) return;
+      char* fresh = new char[n + 1];
+      std::memcpy(fresh, data(), size_ + 1);
+      freeHeap();
+      heap_ = fresh;
+      capacity_ = n;
+   }
+
+   void resize(size_type n, char c = '\0')
+   {
+      if (n > size_) {
+         if (n > capacity_) reserve(grow(n));
+         std::memset(data() + size_, c, n - size_);
+      }
+      size_ = n;
+      data()[n] = '\0';
+   }
+
+   void clear() noexcept
+   {
+      size_ = 0;
+      data()[0] = '\0';
+   }
+
+   // element access
+
+   char* data() noexcept { return capacity_ == N ? inline_ : heap_; }
+   const char* data() const noexcept { return capacity_ == N ? inline_ : heap_; }
+   const char* c_str() const noexcept { return data(); }
+
+   char& operator[](size_type i) noexcept { return data()[i]; }
+   const char& operator[](size_type i) const noexcept { return data()[i]; }
+   char& at(size_type i) { check(i); return data()[i]; }
+   const char& at(size_type i) const { check(i); return data()[i]; }
+   char& front() noexcept { return data()[0]; }
+   const char& front() const noexcept { return data()[0]; }
+   char& back() noexcept { return data()[size_ - 1]; }
+   const char& back() const noexcept { return data()[size_ - 1]; }
+
+   iterator begin() noexcept { return data(); }
+   iterator end() noexcept { return data() + size_; }
+   const_iterator begin() const noexcept { return data(); }
+   const_iterator end() const noexcept { return data() + size_; }
+   const_iterator cbegin() const noexcept { return begin(); }
+   const_iterator cend() const noexcept { return end(); }
+
+   // modifiers
+
+   basic_inline_string& assign(std::string_view s)
+   {
+      if (s.size() > capacity_) {
+         // s may point into *this only if it fits, so no aliasing here
+         char* fresh = new char[s.size() + 1];
+         freeHeap();
+         heap_ = fresh;
+         capacity_ = s.size();
+      }
+      std::memmove(data(), s.data(), s.size());
+      size_ = s.size();
+      data()[size_] = '\0';
+      return *this;
+   }
+
+   basic_inline_string& append(std::string_view s)
+   {
+      if (size_ + s.size() > capacity_) {
+         // s may be a view of *this: copy it into the new block before freeing
+         const size_type newCapacity = grow(size_ + s.size());
+         char* fresh = new char[newCapacity + 1];
+         std::memcpy(fresh, data(), size_);
+         std::memcpy(fresh + size_, s.data(), s.size());
+         freeHeap();
+         heap_ = fresh;
+         capacity_ = newCapacity;
+      } else {
+         std::memmove(data() + size_, s.data(), s.size());
+      }
+      size_ += s.size();
+      data()[size_] = '\0';
+      return *this;
+   }
+
+   basic_inline_string& append(size_type n, char c)
+   {
+      resize(size_ + n, c);
+      return *this;
+   }
+
+   basic_inline_string& operator+=(std::string_view s) { return append(s); }
+   basic_inline_string& operator+=(const char* s) { return append(std::string_view(s)); }
+   basic_inline_string& operator+=(char c) { push_back(c); return *this; }
+
+   void push_back(char c)
+   {
+      if (size_ == capacity_) reserve(grow(size_ + 1));
+      data()[size_++] = c;
+      data()[size_] = '\0';
+   }
+
+   void pop_back() noexcept
+   {
+      data()[--size_] = '\0';
+   }
+
+   basic_inline_string& erase(size_type pos = 0, size_type n = npos)
+   {
+      check(pos, true);
+      n = std::min(n, size_ - pos);
+      std::memmove(data() + pos, data() + pos + n, size_ - pos - n + 1);
+      size_ -= n;
+      return *this;
+   }
+
+   void swap(basic_inline_string& other) noexcept
+   {
+      basic_inline_string tmp(std::move(other));
+      other = std::move(*this);
+      *this = std::move(tmp);
+   }
+
+   // operations, all through std::string_view
+
+   operator std::string_view() const noexcept { return std::string_view(data(), size_); }
+   explicit operator std::string() const { return std::string(data(), size_); }
+   std::string str() const { return std::string(data(), size_); }
+
+   basic_inline_string substr(size_type pos = 0, size_type n = npos) const
+   {
+      check(pos, true);
+      return basic_inline_string(std::string_view(*this).substr(pos, n));
+   }
+
+   size_type find(std::string_view s, size_type pos = 0) const noexcept
+   { return std::string_view(*this).find(s, pos); }
+   size_type find(char c, size_type pos = 0) const noexcept
+   { return std::string_view(*this).find(c, pos); }
+   size_type rfind(std::string_view s, size_type pos = npos) const noexcept
+   { return std::string_view(*this).rfind(s, pos); }
+   size_type rfind(char c, size_type pos = npos) const noexcept
+   { return std::string_view(*this).rfind(c, pos); }
+
+   int compare(std::string_view s) const noexcept { return std::string_view(*this).compare(s); }
+
+   friend bool operator==(const basic_inline_string& a, const basic_inline_string& b) noexcept
+   { return std::string_view(a) == std::string_view(b); }
+   friend bool operator!=(const basic_inline_string& a, const basic_inline_string& b) noexcept
+   { return !(a == b); }
+   friend bool operator<(const basic_inline_string& a, const basic_inline_string& b) noexcept
+   { return std::string_view(a) < std::string_view(b); }
+   friend bool operator>(const basic_inline_string& a, const basic_inline_string& b) noexcept
+   { return b < a; }
+   friend bool operator<=(const basic_inline_string& a, const basic_inline_string& b) noexcept
+   { return !(b < a); }
+   friend bool operator>=(const basic_inline_string& a, const basic_inline_string& b) noexcept
+   { return !(a < b); }
+   friend bool operator==(const basic_inline_string& a, std::string_view b) noexcept
+   { return std::string_view(a) == b; }
+   friend bool operator!=(const basic_inline_string& a, std::string_view b) noexcept
+   { return std::string_view(a) != b; }
+   friend bool operator==(const basic_inline_string& a, const char* b) noexcept
+   { return std::string_view(a) == b; }
+   friend bool operator!=(const basic_inline_string& a, const char* b) noexcept
+   { return std::string_view(a) != b; }
+
+   friend basic_inline_string operator+(basic_inline_string a, std::string_view b)
+   { return std::move(a.append(b)); }
+
+   friend std::ostream& operator<<(std::ostream& os, const basic_inline_string& s)
+   { return os << std::string_view(s); }
+
+private:
+   void check(size_type i, bool endAllowed = false) const
+   {
+      if (i > size_ || (i == size_ && !endAllowed))
+         throw std::out_of_range("basic_inline_string: index out of range");
+   }
+
+   // geometric growth once the string has left the inline buffer
+   size_type grow(size_type needed) const noexcept
+   {
+      return std::max(needed, 2 * capacity_);
+   }
+
+   void freeHeap() noexcept
+   {
+      if (capacity_ != N) {
+         delete[] heap_;
+         capacity_ = N;
+      }
+   }
+
+   // takes other's characters, leaving other empty; *this must be inline
+   void steal(basic_inline_string& other) noexcept
+   {
+      if (other.capacity_ == N) {
+         std::memcpy(inline_, other.inline_, other.size_ + 1);
+      } else {
+         heap_ = other.heap_;
+         capacity_ = other.capacity_;
+         other.capacity_ = N;
+      }
+      size_ = other.size_;
+      other.size_ = 0;
+      other.inline_[0] = '\0';
+   }
+
+   size_type size_ = 0;
+   size_type capacity_ = N;
+   union {
+      char inline_[N + 1];
+      char* heap_;
+   };
+};
+
+using inline_string = basic_inline_string<23>;
+
+namespace std {
+
+template<std::size_t N>
+struct hash<basic_inline_string<N>> {
+   std::size_t operator()(const basic_inline_string<N>& s) const noexcept
+   {
+      return std::hash<std::string_view>()(std::string_view(s));
+   }
+};
+
+} // namespace std
+
+#endif // INLINE_STRING_H
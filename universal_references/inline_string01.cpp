@@ -0,0 +1,124 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <chrono>
+#include <utility>
+#include <new>
+#include <cstdlib>
+#include <assert.h>
+
+#include "demo_support.h"
+#include "inline_string.h"
+
+// Names that never allocate
+//
+// univer_ref01.cpp stores names in a SomeDataStructure,
+//
+//    struct SomeDataStructure {
+//      std::string names[10];
+//      float numbers[10];
+//    };
+//
+// and std::string's 15 inline characters are too few for most of our names, so
+// filling the structure costs up to ten allocations and copying it ten more.
+// With basic_inline_string<31> (inline_string.h) the same names live inside the
+// structure. To show that, this program counts calls to operator new.
+
+static std::size_t allocations = 0;
+
+void* operator new(std::size_t n)
+{
+   ++allocations;
+   if (void* p = std::malloc(n ? n : 1)) return p;
+   throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+template<typename String>
+struct BasicDataStructure {
+  String names[10];
+  float numbers[10];
+};
+
+using SomeDataStructure = BasicDataStructure<std::string>;
+using InlineDataStructure = BasicDataStructure<basic_inline_string<31>>;
+
+const char* const sampleNames[] = {
+   "Mieko Nakamura-Ivanova", "Hanna Margarethe Schmidt", "Emily Rose Thompson",
+   "Dimitar Georgiev Petrov", "Alexandra Konstantinova", "Jean-Baptiste Lefebvre",
+   "Maximilian von Habsburg", "Isabella Cristina Romano", "Oluwaseun Adebayo",
+   "Siobhan Ni Dhomhnaill"
+};
+
+template<typename Data>
+std::size_t fillAndCopy(int rounds)
+{
+   std::size_t total = 0;
+   for (int r = 0; r < rounds; ++r) {
+      Data data;
+      for (int i = 0; i < 10; ++i) {
+         data.names[i] = sampleNames[(i + r) % 10];
+         data.numbers[i] = static_cast<float>(i);
+      }
+      Data copy = data;
+      total += copy.names[r % 10].size();
+   }
+   return total;
+}
+
+int main(const int argc, const char* argv[])
+{
+   {
+      basic_inline_string<31> s = "Dimitar";
+      s += " Georgiev Petrov";
+      assert(s == "Dimitar Georgiev Petrov" && s.is_inline());
+      assert(s.find("Georgiev") == 8 && s.substr(8, 8) == "Georgiev");
+      std::string asString = static_cast<std::string>(s);   // explicit, like std::string(sv)
+      assert(asString == "Dimitar Georgiev Petrov");
+
+      s.append(" and a few more words to spill");
+      assert(!s.is_inline() && s.size() == 53);
+      basic_inline_string<31> moved = std::move(s);
+      assert(moved.size() == 53 && s.empty() && s.is_inline());
+      moved.erase(23);
+      assert(moved == "Dimitar Georgiev Petrov");
+
+      std::map<inline_string, int> m = { { "Dimitar", 1 }, { "Mieko", 2 } };
+      std::unordered_map<inline_string, int> h = { { "Dimitar", 1 }, { "Mieko", 2 } };
+      assert(m["Mieko"] == 2 && h["Dimitar"] == 1);
+   }
+
+   {
+      std::size_t before = allocations;
+      InlineDataStructure data;
+      for (int i = 0; i < 10; ++i)
+         data.names[i] = sampleNames[i];
+      InlineDataStructure copy = data;
+      assert(copy.names[3] == "Dimitar Georgiev Petrov");
+      assert(allocations == before);
+
+      before = allocations;
+      SomeDataStructure stdData;
+      for (int i = 0; i < 10; ++i)
+         stdData.names[i] = sampleNames[i];
+      SomeDataStructure stdCopy = stdData;
+      std::cout << "allocations to fill and copy SomeDataStructure: std::string "
+                << allocations - before << ", basic_inline_string<31> 0" << std::endl;
+   }
+
+   const int rounds = argc > 1 ? std::atoi(argv[1]) : 500000;
+   std::size_t a = 0, b = 0;
+   double stdMs = timeIt([&] { a = fillAndCopy<SomeDataStructure>(rounds); });
+   double inlineMs = timeIt([&] { b = fillAndCopy<InlineDataStructure>(rounds); });
+   assert(a == b);
+
+   std::cout << rounds << " rounds of filling and copying 10 names" << std::endl;
+   std::cout << "std::string:             " << stdMs << " ms" << std::endl;
+   std::cout << "basic_inline_string<31>: " << inlineMs << " ms" << std::endl;
+
+   return 0;
+}
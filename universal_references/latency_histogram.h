@@ -0,0 +1,267 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <thread>
+
+// Latency histograms
+//
+// timeFUncInvocation in univer_ref01.cpp reduces a run to one number. An
+// average hides exactly what hurts: the one call in a thousand that
+// reallocates, takes a page fault or waits for a lock. To see p99.9 we have to
+// keep every latency, or at least where each one fell.
+//
+// basic_latency_histogram<SubBucketBits> keeps counts in log-linear buckets,
+// as HdrHistogram does. Values below 2^SubBucketBits get a bucket each; above
+// that every power of two [2^k, 2^(k+1)) is split into 2^(SubBucketBits-1)
+// equal buckets. Any value in the full uint64_t range is therefore recorded
+// with a relative error below 2^-(SubBucketBits-1) (1/64 with the default 7),
+// whether it is 80 nanoseconds or 80 seconds, in a fixed array of
+// (66 - SubBucketBits) * 2^(SubBucketBits-1) counters (30 KB by default).
+//
+// record is O(1): a count-leading-zeros, two shifts and an increment, no
+// branches on the value range and no allocation. Histograms of the same
+// precision merge with +=, so each thread can fill its own and the results
+// are added at the end. percentile(99.9) returns the largest value that falls
+// in the same bucket as the requested rank, so reported latencies are never
+// optimistic.
+//
+// basic_latency_recorder is the same histogram for long running code that
+// wants to record from any thread and read at any time: it keeps one set of
+// atomic counters per shard, gives each thread its own shard where possible,
+// and snapshot() adds the shards up into a basic_latency_histogram.
+//
+// Values are plain integers; the chrono overloads record nanoseconds.
+
+namespace latency_histogram_detail {
+
+inline unsigned log2Floor(std::uint64_t v) noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+   return 63 - __builtin_clzll(v);
+#else
+   unsigned r = 0;
+   while (v >>= 1) ++r;
+   return r;
+#endif
+}
+
+template<unsigned SubBucketBits>
+struct layout {
+   static_assert(SubBucketBits >= 2 && SubBucketBits <= 16,
+                 "latency histograms support 2 to 16 sub-bucket bits");
+
+   static constexpr std::size_t half = std::size_t(1) << (SubBucketBits - 1);
+   static constexpr std::size_t buckets = (66 - SubBucketBits) * half;
+
+   static std::size_t index(std::uint64_t v) noexcept
+   {
+      // v | (2^SubBucketBits - 1) puts everything below 2^SubBucketBits in shift 0
+      const unsigned shift = log2Floor(v | ((std::uint64_t(1) << SubBucketBits) - 1)) -
+                             (SubBucketBits - 1);
+      return shift * half + static_cast<std::size_t>(v >> shift);
+   }
+
+   static std::uint64_t lowest(std::size_t index) noexcept
+   {
+      if (index < 2 * half) return index;
+      const std::size_t shift = index / half - 1;
+      return static_cast<std::uint64_t>(index - shift * half) << shift;
+   }
+
+   static std::uint64_t highest(std::size_t index) noexcept
+   {
+      return index + 1 == buckets ? ~std::uint64_t(0) : lowest(index + 1) - 1;
+   }
+};
+
+template<typename Rep, typename Period>
+std::uint64_t nanoseconds(std::chrono::duration<Rep, Period> d) noexcept
+{
+   const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+   return ns > 0 ? static_cast<std::uint64_t>(ns) : 0;
+}
+
+} // namespace latency_histogram_detail
+
+template<unsigned SubBucketBits> class basic_latency_recorder;
+
+template<unsigned SubBucketBits = 7>
+class basic_latency_histogram {
+   using layout = latency_histogram_detail::layout<SubBucketBits>;
+
+public:
+   static constexpr std::size_t bucketCount = layout::buckets;
+
+   void record(std::uint64_t value) noexcept
+   {
+      ++counts_[layout::index(value)];
+      ++total_;
+      sum_ += value;
+      min_ = std::min(min_, value);
+      max_ = std::max(max_, value);
+   }
+
+   void record(std::uint64_t value, std::uint64_t count) noexcept
+   {
+      if (count == 0) return;
+      counts_[layout::index(value)] += count;
+      total_ += count;
+      sum_ += value * count;
+      min_ = std::min(min_, value);
+      max_ = std::max(max_, value);
+   }
+
+   template<typename Rep, typename Period>
+   void record(std::chrono::duration<Rep, Period> d) noexcept
+   {
+      record(latency_histogram_detail::nanoseconds(d));
+   }
+
+   basic_latency_histogram& operator+=(const basic_latency_histogram& other) noexcept
+   {
+      for (std::size_t i = 0; i < bucketCount; ++i)
+         counts_[i] += other.counts_[i];
+      total_ += other.total_;
+      sum_ += other.sum_;
+      min_ = std::min(min_, other.min_);
+      max_ = std::max(max_, other.max_);
+      return *this;
+   }
+
+   void reset() noexcept { *this = basic_latency_histogram(); }
+
+   std::uint64_t count() const noexcept { return total_; }
+   std::uint64_t min() const noexcept { return total_ ? min_ : 0; }
+   std::uint64_t max() const noexcept { return max_; }
+   double mean() const noexcept { return total_ ? static_cast<double>(sum_) / total_ : 0; }
+
+   // the value below which p percent of the recorded values fall, p in [0, 100]
+   std::uint64_t percentile(double p) const
+   {
+      if (p < 0 || p > 100) throw std::out_of_range("percentile must be within [0, 100]");
+      if (total_ == 0) return 0;
+      std::uint64_t rank = static_cast<std::uint64_t>(p / 100 * total_ + 0.5);
+      rank = std::max<std::uint64_t>(rank, 1);
+      std::uint64_t seen = 0;
+      for (std::size_t i = 0; i < bucketCount; ++i) {
+         seen += counts_[i];
+         if (seen >= rank) return std::max(min_, std::min(max_, layout::highest(i)));
+      }
+      return max_;
+   }
+
+   // the range of values that land in the same bucket as value
+   static std::uint64_t lowestEquivalent(std::uint64_t value) noexcept
+   {
+      return layout::lowest(layout::index(value));
+   }
+
+   static std::uint64_t highestEquivalent(std::uint64_t value) noexcept
+   {
+      return layout::highest(layout::index(value));
+   }
+
+   // one line: count, mean and the usual percentiles, in the recorded unit
+   void print(std::ostream& os, const char* unit = "ns") const
+   {
+      os << "n=" << count() << " mean=" << mean() << unit;
+      for (double p : { 50.0, 90.0, 99.0, 99.9, 99.99 })
+         os << " p" << p << "=" << percentile(p) << unit;
+      os << " max=" << max() << unit;
+   }
+
+private:
+   friend class basic_latency_recorder<SubBucketBits>;
+
+   std::array<std::uint64_t, bucketCount> counts_{};
+   std::uint64_t total_ = 0;
+   std::uint64_t sum_ = 0;
+   std::uint64_t min_ = ~std::uint64_t(0);
+   std::uint64_t max_ = 0;
+};
+
+using latency_histogram = basic_latency_histogram<>;
+
+template<unsigned SubBucketBits = 7>
+class basic_latency_recorder {
+   using layout = latency_histogram_detail::layout<SubBucketBits>;
+
+public:
+   using histogram = basic_latency_histogram<SubBucketBits>;
+
+   // with as many shards as threads record, no two threads share counters
+   explicit basic_latency_recorder(unsigned shards = std::max(1u, std::thread::hardware_concurrency()))
+      : shardCount_(std::max(1u, shards)), shards_(new shard[shardCount_]) {}
+
+   basic_latency_recorder(const basic_latency_recorder&) = delete;
+   basic_latency_recorder& operator=(const basic_latency_recorder&) = delete;
+
+   void record(std::uint64_t value) noexcept
+   {
+      shard& s = shards_[threadSlot() % shardCount_];
+      constexpr auto relaxed = std::memory_order_relaxed;
+      s.counts[layout::index(value)].fetch_add(1, relaxed);
+      s.sum.fetch_add(value, relaxed);
+      std::uint64_t m = s.min.load(relaxed);
+      while (value < m && !s.min.compare_exchange_weak(m, value, relaxed)) {}
+      m = s.max.load(relaxed);
+      while (value > m && !s.max.compare_exchange_weak(m, value, relaxed)) {}
+   }
+
+   template<typename Rep, typename Period>
+   void record(std::chrono::duration<Rep, Period> d) noexcept
+   {
+      record(latency_histogram_detail::nanoseconds(d));
+   }
+
+   // the counts so far; concurrent records may or may not be included
+   histogram snapshot() const
+   {
+      histogram h;
+      constexpr auto relaxed = std::memory_order_relaxed;
+      for (unsigned k = 0; k < shardCount_; ++k) {
+         const shard& s = shards_[k];
+         for (std::size_t i = 0; i < layout::buckets; ++i) {
+            const std::uint64_t c = s.counts[i].load(relaxed);
+            h.counts_[i] += c;
+            h.total_ += c;
+         }
+         h.sum_ += s.sum.load(relaxed);
+         h.min_ = std::min(h.min_, s.min.load(relaxed));
+         h.max_ = std::max(h.max_, s.max.load(relaxed));
+      }
+      return h;
+   }
+
+private:
+   struct alignas(64) shard {
+      std::array<std::atomic<std::uint64_t>, layout::buckets> counts{};
+      std::atomic<std::uint64_t> sum{ 0 };
+      std::atomic<std::uint64_t> min{ ~std::uint64_t(0) };
+      std::atomic<std::uint64_t> max{ 0 };
+   };
+
+   // threads are numbered in the order they first record anywhere
+   static unsigned threadSlot() noexcept
+   {
+      static std::atomic<unsigned> next{ 0 };
+      static thread_local const unsigned slot = next.fetch_add(1, std::memory_order_relaxed);
+      return slot;
+   }
+
+   const unsigned shardCount_;
+   const std::unique_ptr<shard[]> shards_;
+};
+
+using latency_recorder = basic_latency_recorder<>;
+
+#endif // LATENCY_HISTOGRAM_H
@@ -0,0 +1,152 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <thread>
+#include <chrono>
+#include <random>
+#include <utility>
+#include <cstdint>
+#include <cstdlib>
+#include <assert.h>
+
+#include "demo_support.h"
+#include "latency_histogram.h"
+
+// One number per run is not enough
+//
+// timeFUncInvocation from univer_ref01.cpp forwards a callable and its
+// arguments and reports how long the call took. timeFuncInvocations below
+// does the same for every one of many calls and records each latency in a
+// latency_histogram (latency_histogram.h), so that the tail becomes visible.
+//
+// std::vector<std::string>::push_back is the textbook case: almost every call
+// costs the same few nanoseconds, but the calls that grow the vector move all
+// the elements, and the mean says nothing about them. std::map::emplace
+// allocates a node on every call, which shows in the median instead.
+//
+// Four threads then time the same work with their own histograms, merged at the
+// end, and with a shared latency_recorder, and we print what a single record
+// costs.
+
+auto timeFuncInvocations =
+   [](latency_histogram& h, std::size_t times, auto&& func, auto&&... params)
+   {
+      for (std::size_t i = 0; i < times; ++i) {
+         auto start = std::chrono::steady_clock::now();
+         func(params...);      // not forwarded: they are used again
+         h.record(std::chrono::steady_clock::now() - start);
+      }
+   };
+
+int main(const int argc, const char* argv[])
+{
+   const std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+
+   {
+      // every value lies in its own bucket's range, and buckets follow each other
+      std::mt19937_64 rng(42);
+      for (int i = 0; i < 100000; ++i) {
+         const std::uint64_t v = rng() >> (rng() % 64);
+         const std::uint64_t lo = latency_histogram::lowestEquivalent(v);
+         const std::uint64_t hi = latency_histogram::highestEquivalent(v);
+         assert(lo <= v && v <= hi);
+         assert(hi - lo <= lo / 64);                    // within 1/64
+         assert(latency_histogram::lowestEquivalent(hi + 1) == hi + 1 || hi == ~std::uint64_t(0));
+         (void)lo; (void)hi;
+      }
+      for (std::uint64_t v = 0; v < 128; ++v)
+         assert(latency_histogram::lowestEquivalent(v) == v);
+
+      latency_histogram h, odd, even;
+      for (std::uint64_t v = 1; v <= 100000; ++v) {
+         h.record(v);
+         (v % 2 ? odd : even).record(v);
+      }
+      assert(h.count() == 100000 && h.min() == 1 && h.max() == 100000);
+      assert(h.mean() == 50000.5);
+      const std::uint64_t p50 = h.percentile(50), p999 = h.percentile(99.9);
+      assert(p50 >= 50000 && p50 <= 50000 + 50000 / 64);
+      assert(p999 >= 99900 && p999 <= 100000);
+      assert(h.percentile(100) == 100000 && h.percentile(0) == 1);
+      (void)p50; (void)p999;
+
+      odd += even;
+      for (double p : { 1.0, 25.0, 50.0, 99.0, 99.99 }) {
+         assert(odd.percentile(p) == h.percentile(p));
+         (void)p;
+      }
+      assert(odd.count() == h.count() && odd.mean() == h.mean());
+
+      latency_histogram wide;
+      wide.record(std::chrono::seconds(80));
+      wide.record(std::chrono::nanoseconds(80));
+      wide.record(std::chrono::nanoseconds(-5));        // clock went backwards: 0
+      assert(wide.min() == 0 && wide.max() == 80000000000ull);
+
+      latency_recorder shared(2);
+      std::vector<std::thread> threads;
+      for (int t = 0; t < 4; ++t)
+         threads.emplace_back([&] { for (std::uint64_t v = 1; v <= 100000; ++v) shared.record(v); });
+      for (auto& t : threads) t.join();
+      const latency_histogram all = shared.snapshot();
+      assert(all.count() == 400000 && all.min() == 1 && all.max() == 100000);
+      assert(all.percentile(50) == h.percentile(50));
+      (void)all;
+   }
+
+   {
+      latency_histogram growing, inserting;
+      std::vector<std::string> names;
+      std::map<std::size_t, std::string> byId;
+      std::string name(20, 'w');
+      timeFuncInvocations(growing, n, [&](const std::string& s) { names.push_back(s); }, name);
+      timeFuncInvocations(inserting, n,
+                          [&](const std::string& s) { byId.emplace(byId.size(), s); }, name);
+      std::cout << "vector::push_back: ";
+      growing.print(std::cout);
+      std::cout << std::endl << "map::emplace:      ";
+      inserting.print(std::cout);
+      std::cout << std::endl;
+   }
+
+   {
+      const unsigned threads = 4;
+      const std::size_t perThread = n;
+      std::vector<latency_histogram> own(threads);
+      latency_recorder shared;
+      std::mt19937_64 rng(7);
+      std::vector<std::uint64_t> values(4096);
+      for (auto& v : values) v = rng() % 1000000;
+
+      auto run = [&](auto&& recordOne) {
+         return timeIt([&] {
+            std::vector<std::thread> workers;
+            for (unsigned t = 0; t < threads; ++t)
+               workers.emplace_back([&, t] {
+                  for (std::size_t i = 0; i < perThread; ++i)
+                     recordOne(t, values[i & 4095]);
+               });
+            for (auto& w : workers) w.join();
+         });
+      };
+      const double ownMs = run([&](unsigned t, std::uint64_t v) { own[t].record(v); });
+      const double sharedMs = run([&](unsigned, std::uint64_t v) { shared.record(v); });
+
+      latency_histogram merged;
+      const double mergeMs = timeIt([&] { for (const auto& h : own) merged += h; });
+      const latency_histogram snapshot = shared.snapshot();
+      assert(merged.count() == threads * perThread && snapshot.count() == merged.count());
+      assert(merged.percentile(99.9) == snapshot.percentile(99.9));
+      (void)snapshot;
+
+      const double records = static_cast<double>(threads * perThread);
+      std::cout << "record, histogram per thread: " << ownMs * 1e6 / records << " ns, merging "
+                << threads << " histograms " << mergeMs << " ms (p99.9 " << merged.percentile(99.9)
+                << ")" << std::endl;
+      std::cout << "record, shared recorder:      " << sharedMs * 1e6 / records << " ns ("
+                << sizeof(latency_histogram) << " bytes per histogram)" << std::endl;
+   }
+
+   return 0;
+}
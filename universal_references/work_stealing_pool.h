@@ -0,0 +1,585 @@
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// A work-stealing thread pool
+//
+// Each worker owns a Chase-Lev deque. A worker pushes the tasks it creates onto
+// the bottom of its own deque and takes them back from the bottom, newest
+// first, without any locking in the common case; idle workers steal from the
+// top of other workers' deques, oldest first, which tends to hand them the
+// biggest remaining pieces of a recursive computation. Tasks from threads
+// outside the pool go through a shared injection queue.
+//
+// The interface takes callables the way timeFUncInvocation in univer_ref01.cpp
+// does, as universal references forwarded to where they are stored or called:
+//
+//  * submit(f, args...) runs f(args...) asynchronously and returns a
+//    task_future. Callable and arguments are moved (or copied, for lvalues)
+//    into one heap block that also holds the result; move-only callables and
+//    arguments are fine.
+//
+//  * parallel_invoke(f1, f2, ...) runs the callables in parallel and returns
+//    when all are done; parallel_for(first, last, f) calls f(i) for every i in
+//    [first, last), splitting the range recursively. These are fork-join: the
+//    tasks live on the caller's stack until it has joined them, so they
+//    allocate nothing.
+//
+// No task is wrapped in a std::function, which would allocate for anything but
+// the smallest callables and would reject move-only ones.
+//
+// A worker that waits, for a future or at a join, does not block: it runs
+// other tasks of the pool until what it waits for is done. A thread outside the
+// pool blocks instead. Helping would run the oldest, largest tasks nested on its
+// stack, as deep as the recursion goes, so parallel_invoke and parallel_for
+// hand the whole fork-join to a worker, and get() waits for a worker to finish
+// the task. Exceptions thrown
+// by a task are rethrown by get() or by the joining parallel_invoke or
+// parallel_for.
+//
+// Idle workers sleep on a condition variable and are woken when tasks are
+// pushed. With pin set, worker i is bound to the i-th of the CPUs the process
+// may run on, wrapping around (Linux only).
+
+namespace work_stealing_detail {
+
+struct task {
+   explicit task(void (*run)(task*) noexcept) noexcept : run(run) {}
+   void (*run)(task*) noexcept;
+   std::atomic<bool> done{ false };
+   std::exception_ptr error;
+};
+
+// a fork-join task on the stack of the forking thread
+template<typename F>
+struct stack_task : task {
+   explicit stack_task(F& f) noexcept : task(&execute), f(f) {}
+
+   static void execute(task* t) noexcept
+   {
+      stack_task* self = static_cast<stack_task*>(t);
+      try {
+         std::forward<F>(self->f)();
+      } catch (...) {
+         self->error = std::current_exception();
+      }
+      self->done.store(true, std::memory_order_release);   // last touch: self may go away
+   }
+
+   F& f;
+};
+
+template<typename R>
+struct result_holder {
+   std::optional<R> value;
+   template<typename G> void set(G&& g) { value.emplace(std::forward<G>(g)()); }
+   R take() { return std::move(*value); }
+};
+
+template<>
+struct result_holder<void> {
+   template<typename G> void set(G&& g) { std::forward<G>(g)(); }
+   void take() noexcept {}
+};
+
+template<typename R>
+struct async_state : task {
+   using task::task;
+   result_holder<R> result;
+   std::shared_ptr<async_state> keepAlive;       // the pool's reference until it has run
+};
+
+// callable, arguments and result of submit, in one allocation
+template<typename R, typename F, typename... Args>
+struct async_task : async_state<R> {
+   template<typename G, typename... A>
+   async_task(G&& g, A&&... a)
+      : async_state<R>(&execute), f(std::forward<G>(g)), args(std::forward<A>(a)...) {}
+
+   static void execute(task* t) noexcept
+   {
+      async_task* self = static_cast<async_task*>(t);
+      std::shared_ptr<async_state<R>> alive = std::move(self->keepAlive);
+      try {
+         self->result.set([self] { return std::apply(std::move(self->f), std::move(self->args)); });
+      } catch (...) {
+         self->error = std::current_exception();
+      }
+      self->done.store(true, std::memory_order_release);
+   }
+
+   F f;
+   std::tuple<Args...> args;
+};
+
+// Chase-Lev deque of task pointers (Le, Pop, Cohen, Zappa Nardelli 2013).
+// push and take are called by the owner only, steal by anybody.
+class deque {
+   struct ring {
+      explicit ring(std::int64_t capacity)
+         : capacity(capacity), slots(new std::atomic<task*>[capacity]) {}
+      std::int64_t capacity;
+      std::unique_ptr<std::atomic<task*>[]> slots;
+      // the fences below already order these; acquire/release costs nothing on
+      // x86 and makes the publication visible to ThreadSanitizer
+      task* get(std::int64_t i) const noexcept
+      { return slots[i & (capacity - 1)].load(std::memory_order_acquire); }
+      void put(std::int64_t i, task* t) noexcept
+      { slots[i & (capacity - 1)].store(t, std::memory_order_release); }
+   };
+
+public:
+   deque()
+   {
+      rings_.push_back(std::make_unique<ring>(1024));
+      ring_.store(rings_.back().get(), std::memory_order_relaxed);
+   }
+
+   void push(task* t)
+   {
+      const std::int64_t b = bottom_.load(std::memory_order_relaxed);
+      const std::int64_t top = top_.load(std::memory_order_acquire);
+      ring* r = ring_.load(std::memory_order_relaxed);
+      if (b - top > r->capacity - 1)
+         r = grow(r, top, b);
+      r->put(b, t);
+      std::atomic_thread_fence(std::memory_order_release);
+      bottom_.store(b + 1, std::memory_order_relaxed);
+   }
+
+   task* take() noexcept
+   {
+      const std::int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+      ring* r = ring_.load(std::memory_order_relaxed);
+      bottom_.store(b, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      std::int64_t top = top_.load(std::memory_order_relaxed);
+      task* t = nullptr;
+      if (top <= b) {
+         t = r->get(b);
+         if (top == b) {
+            // the last one: race the thieves for it
+            if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                              std::memory_order_relaxed))
+               t = nullptr;
+            bottom_.store(b + 1, std::memory_order_relaxed);
+         }
+      } else {
+         bottom_.store(b + 1, std::memory_order_relaxed);
+      }
+      return t;
+   }
+
+   task* steal() noexcept
+   {
+      std::int64_t top = top_.load(std::memory_order_acquire);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      const std::int64_t b = bottom_.load(std::memory_order_acquire);
+      if (top >= b) return nullptr;
+      task* t = ring_.load(std::memory_order_acquire)->get(top);
+      if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                        std::memory_order_relaxed))
+         return nullptr;                              // lost the race
+      return t;
+   }
+
+   bool empty() const noexcept
+   {
+      return bottom_.load(std::memory_order_relaxed) <= top_.load(std::memory_order_relaxed);
+   }
+
+private:
+   // old rings stay alive: a thief may still be reading one
+   ring* grow(ring* old, std::int64_t top, std::int64_t bottom)
+   {
+      rings_.push_back(std::make_unique<ring>(2 * old->capacity));
+      ring* fresh = rings_.back().get();
+      for (std::int64_t i = top; i < bottom; ++i)
+         fresh->put(i, old->get(i));
+      ring_.store(fresh, std::memory_order_release);
+      return fresh;
+   }
+
+   alignas(64) std::atomic<std::int64_t> top_{ 0 };
+   alignas(64) std::atomic<std::int64_t> bottom_{ 0 };
+   std::atomic<ring*> ring_;
+   std::vector<std::unique_ptr<ring>> rings_;
+};
+
+} // namespace work_stealing_detail
+
+class work_stealing_pool;
+
+// the result of work_stealing_pool::submit
+template<typename R>
+class task_future {
+public:
+   task_future() = default;
+
+   bool valid() const noexcept { return state_ != nullptr; }
+   bool ready() const noexcept { return state_->done.load(std::memory_order_acquire); }
+
+   // waits, running other tasks meanwhile if called by a worker of the pool;
+   // rethrows the task's exception
+   R get();
+
+private:
+   friend class work_stealing_pool;
+   task_future(work_stealing_pool* pool, std::shared_ptr<work_stealing_detail::async_state<R>> s)
+      : pool_(pool), state_(std::move(s)) {}
+
+   work_stealing_pool* pool_ = nullptr;
+   std::shared_ptr<work_stealing_detail::async_state<R>> state_;
+};
+
+class work_stealing_pool {
+   using task = work_stealing_detail::task;
+
+public:
+   explicit work_stealing_pool(unsigned threads = std::thread::hardware_concurrency(),
+                               bool pin = false)
+   {
+      if (threads == 0) threads = 1;
+      for (unsigned i = 0; i < threads; ++i)
+         workers_.emplace_back(new worker);
+      for (unsigned i = 0; i < threads; ++i)
+         workers_[i]->thread = std::thread([this, i, pin] { run(i, pin); });
+   }
+
+   work_stealing_pool(const work_stealing_pool&) = delete;
+   work_stealing_pool& operator=(const work_stealing_pool&) = delete;
+
+   // runs the tasks still queued, then joins the workers
+   ~work_stealing_pool()
+   {
+      stop_.store(true);
+      {
+         std::lock_guard<std::mutex> lock(sleepMutex_);
+         wake_.notify_all();
+      }
+      for (auto& w : workers_)
+         w->thread.join();
+   }
+
+   unsigned size() const noexcept { return static_cast<unsigned>(workers_.size()); }
+
+   // a process-wide pool with one worker per core
+   static work_stealing_pool& shared()
+   {
+      static work_stealing_pool pool;
+      return pool;
+   }
+
+   template<typename F, typename... Args>
+   auto submit(F&& f, Args&&... args)
+      -> task_future<std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>>
+   {
+      using R = std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>;
+      using state = work_stealing_detail::async_task<R, std::decay_t<F>, std::decay_t<Args>...>;
+      std::shared_ptr<state> s =
+         std::make_shared<state>(std::forward<F>(f), std::forward<Args>(args)...);
+      s->keepAlive = s;
+      schedule(s.get());
+      return task_future<R>(this, std::move(s));
+   }
+
+   template<typename... F>
+   void parallel_invoke(F&&... fs)
+   {
+      if (currentIndex() >= 0) {
+         forkJoin(work_stealing_detail::stack_task<F>(fs)...);
+         return;
+      }
+      // from outside the pool a worker runs the whole fork-join
+      auto whole = [&] { forkJoin(work_stealing_detail::stack_task<F>(fs)...); };
+      work_stealing_detail::stack_task<decltype(whole)> t(whole);
+      schedule(&t);
+      waitBlocking(&t);
+      if (t.error) std::rethrow_exception(t.error);
+   }
+
+   // f(i) for each i in [first, last); ranges of up to grain indexes run
+   // sequentially (0: about eight pieces per worker)
+   template<typename Index, typename F>
+   void parallel_for(Index first, Index last, F&& f, Index grain = 0)
+   {
+      if (!(first < last)) return;
+      if (grain <= 0) {
+         grain = static_cast<Index>((last - first) / (8 * static_cast<Index>(size())));
+         if (grain <= 0) grain = 1;
+      }
+      splitFor(first, last, f, grain);
+   }
+
+   // runs tasks of the pool until done() is true
+   template<typename Pred>
+   void waitUntil(Pred done)
+   {
+      const int self = currentIndex();
+      unsigned idle = 0;
+      while (!done()) {
+         if (task* t = findWork(self)) {
+            runFound(t);
+            idle = 0;
+         } else if (++idle > 64) {
+            std::this_thread::yield();
+         }
+      }
+   }
+
+private:
+   template<typename R> friend class task_future;
+
+   struct worker {
+      work_stealing_detail::deque tasks;
+      std::thread thread;
+   };
+
+   // the worker index of the calling thread in this pool, or -1
+   int currentIndex() const noexcept
+   {
+      return current().pool == this ? current().index : -1;
+   }
+
+   struct identity {
+      const work_stealing_pool* pool = nullptr;
+      int index = -1;
+   };
+
+   static identity& current() noexcept
+   {
+      static thread_local identity id;
+      return id;
+   }
+
+   void schedule(task* t)
+   {
+      const int self = currentIndex();
+      if (self >= 0) {
+         workers_[self]->tasks.push(t);
+      } else {
+         std::lock_guard<std::mutex> lock(injectMutex_);
+         injected_.push_back(t);
+         injectedCount_.fetch_add(1, std::memory_order_relaxed);
+      }
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (sleepers_.load(std::memory_order_relaxed) > 0) {
+         std::lock_guard<std::mutex> lock(sleepMutex_);
+         wake_.notify_one();
+      }
+   }
+
+   // waits for t: helping if called by a worker, blocked otherwise
+   void wait(const task* t)
+   {
+      if (currentIndex() >= 0)
+         waitUntil([t] { return t->done.load(std::memory_order_acquire); });
+      else
+         waitBlocking(t);
+   }
+
+   // for threads outside the pool
+   void waitBlocking(const task* t)
+   {
+      std::unique_lock<std::mutex> lock(blockedMutex_);
+      blocked_.fetch_add(1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);    // pairs with runFound
+      while (!t->done.load(std::memory_order_acquire))
+         unblock_.wait_for(lock, std::chrono::milliseconds(10));   // backstop, see runFound
+      blocked_.fetch_sub(1, std::memory_order_relaxed);
+   }
+
+   // runs a task from findWork, which is where the tasks outside threads wait
+   // for are picked up, and wakes those threads. Only a task pushed by a worker
+   // and awaited from outside can finish elsewhere; the backstop catches it.
+   void runFound(task* t)
+   {
+      t->run(t);                                       // t may be gone now
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (blocked_.load(std::memory_order_relaxed) > 0) {
+         std::lock_guard<std::mutex> lock(blockedMutex_);
+         unblock_.notify_all();
+      }
+   }
+
+   task* findWork(int self)
+   {
+      if (self >= 0)
+         if (task* t = workers_[self]->tasks.take()) return t;
+      if (injectedCount_.load(std::memory_order_relaxed) > 0) {
+         std::lock_guard<std::mutex> lock(injectMutex_);
+         if (!injected_.empty()) {
+            task* t = injected_.front();
+            injected_.pop_front();
+            injectedCount_.fetch_sub(1, std::memory_order_relaxed);
+            return t;
+         }
+      }
+      // steal, starting from a pseudo-random victim
+      const std::size_t n = workers_.size();
+      thread_local std::uint32_t seed = 0x9E3779B9u ^ static_cast<std::uint32_t>(
+         std::hash<std::thread::id>()(std::this_thread::get_id()));
+      seed ^= seed << 13; seed ^= seed >> 17; seed ^= seed << 5;
+      const std::size_t start = seed % n;
+      for (std::size_t k = 0; k < n; ++k) {
+         const std::size_t v = (start + k) % n;
+         if (static_cast<int>(v) == self) continue;
+         if (task* t = workers_[v]->tasks.steal()) return t;
+      }
+      return nullptr;
+   }
+
+   bool hasWork() const noexcept
+   {
+      if (injectedCount_.load(std::memory_order_relaxed) > 0) return true;
+      for (const auto& w : workers_)
+         if (!w->tasks.empty()) return true;
+      return false;
+   }
+
+#if defined(__linux__)
+   // binds the calling thread to the index-th CPU of the process's affinity
+   // mask (a cgroup cpuset may leave out any of them); leaves it alone if the
+   // mask cannot be read
+   static void pinTo(unsigned index) noexcept
+   {
+      cpu_set_t allowed;
+      CPU_ZERO(&allowed);
+      if (sched_getaffinity(0, sizeof allowed, &allowed) != 0) return;
+      const int count = CPU_COUNT(&allowed);
+      if (count <= 0) return;
+      int skip = static_cast<int>(index % static_cast<unsigned>(count));
+      for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+         if (!CPU_ISSET(cpu, &allowed) || skip-- > 0) continue;
+         cpu_set_t cpus;
+         CPU_ZERO(&cpus);
+         CPU_SET(cpu, &cpus);
+         pthread_setaffinity_np(pthread_self(), sizeof cpus, &cpus);
+         return;
+      }
+   }
+#endif
+
+   void run(unsigned index, bool pin)
+   {
+      current() = identity{ this, static_cast<int>(index) };
+#if defined(__linux__)
+      if (pin) pinTo(index);
+#else
+      (void)pin;
+#endif
+      unsigned idle = 0;
+      for (;;) {
+         if (task* t = findWork(static_cast<int>(index))) {
+            runFound(t);
+            idle = 0;
+            continue;
+         }
+         if (++idle < 64) {
+            std::this_thread::yield();
+            continue;
+         }
+         std::unique_lock<std::mutex> lock(sleepMutex_);
+         sleepers_.fetch_add(1, std::memory_order_seq_cst);
+         if (stop_.load() && !hasWork()) {
+            sleepers_.fetch_sub(1, std::memory_order_relaxed);
+            return;
+         }
+         if (!hasWork())
+            wake_.wait_for(lock, std::chrono::milliseconds(10));   // backstop for a missed wakeup
+         sleepers_.fetch_sub(1, std::memory_order_relaxed);
+         idle = 0;
+      }
+   }
+
+   template<typename... T>
+   void forkJoin(T&&... tasks)
+   {
+      forkJoinImpl(static_cast<task*>(&tasks)...);
+   }
+
+   template<typename... T>
+   void forkJoinImpl(task* first, T... rest)
+   {
+      task* forked[] = { rest... };
+      for (task* t : forked)
+         schedule(t);
+      first->run(first);
+      // take back what nobody has stolen, newest first; stolen tasks are helped along
+      const int self = currentIndex();
+      if (self >= 0) {
+         for (std::size_t i = sizeof...(rest); i-- > 0;) {
+            task* t = workers_[self]->tasks.take();
+            if (!t) break;
+            t->run(t);
+         }
+      }
+      for (task* t : forked)
+         waitUntil([t] { return t->done.load(std::memory_order_acquire); });
+      if (first->error) std::rethrow_exception(first->error);
+      for (task* t : forked)
+         if (t->error) std::rethrow_exception(t->error);
+   }
+
+   void forkJoinImpl(task* only)
+   {
+      only->run(only);
+      if (only->error) std::rethrow_exception(only->error);
+   }
+
+   template<typename Index, typename F>
+   void splitFor(Index first, Index last, F& f, Index grain)
+   {
+      if (last - first <= grain) {
+         for (Index i = first; i < last; ++i)
+            f(i);
+         return;
+      }
+      const Index mid = first + (last - first) / 2;
+      parallel_invoke([&] { splitFor(first, mid, f, grain); },
+                      [&] { splitFor(mid, last, f, grain); });
+   }
+
+   std::vector<std::unique_ptr<worker>> workers_;
+   std::mutex injectMutex_;
+   std::deque<task*> injected_;
+   std::atomic<std::size_t> injectedCount_{ 0 };
+   std::mutex sleepMutex_;
+   std::condition_variable wake_;
+   std::atomic<int> sleepers_{ 0 };
+   std::atomic<bool> stop_{ false };
+   std::mutex blockedMutex_;
+   std::condition_variable unblock_;
+   std::atomic<int> blocked_{ 0 };                // outside threads in waitBlocking
+};
+
+template<typename R>
+R task_future<R>::get()
+{
+   work_stealing_detail::async_state<R>* s = state_.get();
+   pool_->wait(s);
+   if (s->error) std::rethrow_exception(s->error);
+   return s->result.take();
+}
+
+#endif // WORK_STEALING_POOL_H
@@ -0,0 +1,150 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+#include <cstdlib>
+#include <cstring>
+#include <assert.h>
+
+#include "work_stealing_pool.h"
+
+// Forwarding callables to other threads
+//
+// timeFUncInvocation in univer_ref01.cpp takes any callable and any arguments
+// as universal references and forwards them, unchanged in value category, to
+// the call. work_stealing_pool (work_stealing_pool.h) does the same across
+// threads: submit(f, args...) moves rvalues and copies lvalues into the task,
+// so a std::unique_ptr argument works and a large std::string argument is not
+// copied when passed with std::move.
+//
+// The benchmark is the usual fork-join one: fib(n) computed by forking both
+// recursive calls down to a cutoff, compared with the sequential recursion,
+// and a parallel_for sum. With --pin the workers are bound to cores.
+
+long fib(int n)
+{
+   return n < 2 ? n : fib(n - 1) + fib(n - 2);
+}
+
+long parallelFib(work_stealing_pool& pool, int n, int cutoff)
+{
+   if (n <= cutoff) return fib(n);
+   long a = 0, b = 0;
+   pool.parallel_invoke([&] { a = parallelFib(pool, n - 1, cutoff); },
+                        [&] { b = parallelFib(pool, n - 2, cutoff); });
+   return a + b;
+}
+
+auto timeFuncInvocation =
+   [](auto&& func, auto&&... params)
+   {
+      auto start = std::chrono::steady_clock::now();
+      std::forward<decltype(func)>(func)(
+         std::forward<decltype(params)>(params)...
+      );
+      std::chrono::duration<double, std::milli> elapsed =
+         std::chrono::steady_clock::now() - start;
+      return elapsed.count();
+   };
+
+struct CopyCounter {
+   static int copies;
+   CopyCounter() = default;
+   CopyCounter(const CopyCounter&) { ++copies; }
+   CopyCounter(CopyCounter&&) noexcept {}
+};
+int CopyCounter::copies = 0;
+
+int main(const int argc, const char* argv[])
+{
+   bool pin = false;
+   int n = 32;
+   for (int i = 1; i < argc; ++i) {
+      if (std::strcmp(argv[i], "--pin") == 0) pin = true;
+      else n = std::atoi(argv[i]);
+   }
+   work_stealing_pool pool(std::thread::hardware_concurrency(), pin);
+
+   {
+      // move-only callables and arguments, forwarded as given
+      auto p = std::make_unique<int>(41);
+      auto answer = pool.submit([q = std::move(p)](std::unique_ptr<int> r) { return *q + *r - 40; },
+                                std::make_unique<int>(41));
+      assert(answer.get() == 42);
+
+      CopyCounter c;
+      pool.submit([](const CopyCounter&) {}, c).get();         // lvalue: one copy
+      assert(CopyCounter::copies == 1);
+      pool.submit([](const CopyCounter&) {}, std::move(c)).get();
+      assert(CopyCounter::copies == 1);
+
+      std::string s(1000, 'x');
+      auto length = pool.submit([](const std::string& t) { return t.size(); }, std::move(s));
+      assert(length.get() == 1000);
+
+      auto failing = pool.submit([] { throw std::runtime_error("task failed"); });
+      bool caught = false;
+      try { failing.get(); } catch (const std::runtime_error&) { caught = true; }
+      assert(caught);
+      (void)caught;
+   }
+   {
+      std::atomic<int> ran{ 0 };
+      pool.parallel_invoke([&] { ++ran; }, [&] { ++ran; }, [&] { ++ran; });
+      assert(ran == 3);
+
+      std::vector<int> squares(10000);
+      pool.parallel_for(std::size_t(0), squares.size(),
+                        [&](std::size_t i) { squares[i] = static_cast<int>(i * i % 1000); });
+      for (std::size_t i = 0; i < squares.size(); ++i)
+         assert(squares[i] == static_cast<int>(i * i % 1000));
+
+      bool caught = false;
+      try {
+         pool.parallel_invoke([] {}, [] { throw std::logic_error("forked task failed"); });
+      } catch (const std::logic_error&) {
+         caught = true;
+      }
+      assert(caught);
+      (void)caught;
+      assert(parallelFib(pool, 20, 5) == fib(20));
+   }
+
+   std::cout << pool.size() << " workers" << (pin ? ", pinned" : "") << std::endl;
+
+   long serial = 0, parallel = 0, fine = 0;
+   double serialMs = timeFuncInvocation([&](int m) { serial = fib(m); }, n);
+   double parallelMs = timeFuncInvocation([&](int m) { parallel = parallelFib(pool, m, m - 12); }, n);
+   // cutoff 10: several hundred thousand forks, mostly overhead
+   double fineMs = timeFuncInvocation([&](int m) { fine = parallelFib(pool, m, 10); }, n);
+   assert(serial == parallel && serial == fine);
+
+   std::vector<double> data(20000000);
+   std::iota(data.begin(), data.end(), 0.0);
+   double seqSum = 0;
+   double seqSumMs = timeFuncInvocation([&] {
+      seqSum = std::accumulate(data.begin(), data.end(), 0.0);
+   });
+   const std::size_t chunks = 64;
+   std::vector<double> partial(chunks);
+   double parSumMs = timeFuncInvocation([&] {
+      pool.parallel_for(std::size_t(0), chunks, [&](std::size_t c) {
+         const std::size_t lo = data.size() * c / chunks, hi = data.size() * (c + 1) / chunks;
+         partial[c] = std::accumulate(data.begin() + lo, data.begin() + hi, 0.0);
+      }, std::size_t(1));
+   });
+   const double parSum = std::accumulate(partial.begin(), partial.end(), 0.0);
+
+   std::cout << "fib(" << n << ") = " << serial << ": sequential " << serialMs << " ms, forked "
+             << parallelMs << " ms, forked down to fib(10) " << fineMs << " ms" << std::endl;
+   std::cout << "sum of " << data.size() << " doubles: sequential " << seqSumMs
+             << " ms, parallel_for " << parSumMs << " ms (" << seqSum << ", " << parSum << ")"
+             << std::endl;
+
+   return 0;
+}
@@ -0,0 +1,338 @@
+#ifndef RING_QUEUE_H
+#define RING_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Bounded lock-free queues
+//
+// A queue made of a mutex, a condition variable and a std::deque costs a lock
+// and usually a futex call for every item, and all producers and consumers
+// fight over the one mutex. Past a few million items per second that is all a
+// pipeline does.
+//
+// Both queues here keep their elements in a ring of preallocated slots and
+// coordinate with atomics only:
+//
+//  * spsc_queue is for exactly one producer and one consumer thread. Each side
+//    owns one index and only reads the other's; it keeps a cached copy of the
+//    other index and only reloads it (a cache miss on a line the other core
+//    writes) when the cached value says the ring is full, or empty.
+//
+//  * mpmc_queue (Vyukov's bounded queue) is for any number of producers and
+//    consumers. Every slot carries a sequence number that says whether it is
+//    free for the producer of ticket i or holds the element for the consumer of
+//    ticket i, so a producer only competes for the tail ticket, a consumer for
+//    the head ticket, and never both for the same slot.
+//
+// Elements are moved in and out of the slots. As using_noexcept01.cpp explains
+// for std::vector, a move that may throw halfway leaves no good way to recover,
+// so both queues insist on element types with noexcept move construction, such
+// as std::unique_ptr<Widget>; nothing is ever copied.
+//
+// try_push and try_pop never block: they fail when the ring is full, or empty.
+// push_batch and pop_batch move up to n elements with one synchronization
+// (one index store, or one successful CAS) for the whole batch and return how
+// many they moved. Capacities are rounded up to a power of two.
+
+namespace ring_queue_detail {
+
+constexpr std::size_t cacheLine = 64;
+
+inline std::size_t roundUpToPowerOfTwo(std::size_t n)
+{
+   if (n < 2) return 2;
+   std::size_t p = 1;
+   while (p < n) p <<= 1;
+   return p;
+}
+
+template<typename T>
+struct storage {
+   alignas(T) unsigned char bytes[sizeof(T)];
+
+   T* get() noexcept { return std::launder(reinterpret_cast<T*>(bytes)); }
+};
+
+} // namespace ring_queue_detail
+
+template<typename T>
+class spsc_queue {
+   static_assert(std::is_nothrow_move_constructible<T>::value,
+                 "spsc_queue moves elements and needs a noexcept move constructor");
+   static_assert(std::is_nothrow_move_assignable<T>::value,
+                 "spsc_queue moves elements out by assignment and needs it noexcept");
+   static_assert(std::is_nothrow_destructible<T>::value, "");
+
+public:
+   using value_type = T;
+
+   explicit spsc_queue(std::size_t capacity)
+      : mask_(ring_queue_detail::roundUpToPowerOfTwo(capacity) - 1),
+        slots_(new ring_queue_detail::storage<T>[mask_ + 1]) {}
+
+   spsc_queue(const spsc_queue&) = delete;
+   spsc_queue& operator=(const spsc_queue&) = delete;
+
+   ~spsc_queue()
+   {
+      const std::size_t tail = tail_.load(std::memory_order_relaxed);
+      for (std::size_t i = head_.load(std::memory_order_relaxed); i != tail; ++i)
+         slots_[i & mask_].get()->~T();
+   }
+
+   std::size_t capacity() const noexcept { return mask_ + 1; }
+
+   // producer side
+
+   template<typename... Args>
+   bool try_emplace(Args&&... args) noexcept(std::is_nothrow_constructible<T, Args...>::value)
+   {
+      const std::size_t tail = tail_.load(std::memory_order_relaxed);
+      if (tail - cachedHead_ == capacity()) {
+         cachedHead_ = head_.load(std::memory_order_acquire);
+         if (tail - cachedHead_ == capacity()) return false;
+      }
+      ::new (slots_[tail & mask_].bytes) T(std::forward<Args>(args)...);
+      tail_.store(tail + 1, std::memory_order_release);
+      return true;
+   }
+
+   bool try_push(T&& value) noexcept { return try_emplace(std::move(value)); }
+
+   // moves up to n elements from first; returns how many
+   std::size_t push_batch(T* first, std::size_t n) noexcept
+   {
+      const std::size_t tail = tail_.load(std::memory_order_relaxed);
+      std::size_t room = capacity() - (tail - cachedHead_);
+      if (room < n) {
+         cachedHead_ = head_.load(std::memory_order_acquire);
+         room = capacity() - (tail - cachedHead_);
+      }
+      if (n > room) n = room;
+      for (std::size_t i = 0; i < n; ++i)
+         ::new (slots_[(tail + i) & mask_].bytes) T(std::move(first[i]));
+      tail_.store(tail + n, std::memory_order_release);
+      return n;
+   }
+
+   // consumer side
+
+   bool try_pop(T& out) noexcept
+   {
+      const std::size_t head = head_.load(std::memory_order_relaxed);
+      if (head == cachedTail_) {
+         cachedTail_ = tail_.load(std::memory_order_acquire);
+         if (head == cachedTail_) return false;
+      }
+      T* slot = slots_[head & mask_].get();
+      out = std::move(*slot);
+      slot->~T();
+      head_.store(head + 1, std::memory_order_release);
+      return true;
+   }
+
+   // moves up to n elements to out; returns how many
+   std::size_t pop_batch(T* out, std::size_t n) noexcept
+   {
+      const std::size_t head = head_.load(std::memory_order_relaxed);
+      std::size_t available = cachedTail_ - head;
+      if (available < n) {
+         cachedTail_ = tail_.load(std::memory_order_acquire);
+         available = cachedTail_ - head;
+      }
+      if (n > available) n = available;
+      for (std::size_t i = 0; i < n; ++i) {
+         T* slot = slots_[(head + i) & mask_].get();
+         out[i] = std::move(*slot);
+         slot->~T();
+      }
+      head_.store(head + n, std::memory_order_release);
+      return n;
+   }
+
+   // a snapshot; exact only when neither side is active
+   std::size_t size() const noexcept
+   {
+      return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+   }
+
+private:
+   const std::size_t mask_;
+   const std::unique_ptr<ring_queue_detail::storage<T>[]> slots_;
+
+   // written by the producer
+   alignas(ring_queue_detail::cacheLine) std::atomic<std::size_t> tail_{ 0 };
+   std::size_t cachedHead_ = 0;
+   // written by the consumer
+   alignas(ring_queue_detail::cacheLine) std::atomic<std::size_t> head_{ 0 };
+   std::size_t cachedTail_ = 0;
+};
+
+template<typename T>
+class mpmc_queue {
+   static_assert(std::is_nothrow_move_constructible<T>::value,
+                 "mpmc_queue moves elements and needs a noexcept move constructor");
+   static_assert(std::is_nothrow_move_assignable<T>::value,
+                 "mpmc_queue moves elements out by assignment and needs it noexcept");
+   static_assert(std::is_nothrow_destructible<T>::value, "");
+
+   // seq == ticket: free for the producer of ticket; seq == ticket + 1: holds
+   // the element of ticket for its consumer
+   struct cell {
+      std::atomic<std::size_t> seq;
+      ring_queue_detail::storage<T> value;
+   };
+
+public:
+   using value_type = T;
+
+   explicit mpmc_queue(std::size_t capacity)
+      : mask_(ring_queue_detail::roundUpToPowerOfTwo(capacity) - 1),
+        cells_(new cell[mask_ + 1])
+   {
+      for (std::size_t i = 0; i <= mask_; ++i)
+         cells_[i].seq.store(i, std::memory_order_relaxed);
+   }
+
+   mpmc_queue(const mpmc_queue&) = delete;
+   mpmc_queue& operator=(const mpmc_queue&) = delete;
+
+   ~mpmc_queue()
+   {
+      const std::size_t tail = tail_.load(std::memory_order_relaxed);
+      for (std::size_t i = head_.load(std::memory_order_relaxed); i != tail; ++i)
+         cells_[i & mask_].value.get()->~T();
+   }
+
+   std::size_t capacity() const noexcept { return mask_ + 1; }
+
+   // the slot is claimed before T is constructed in it, and a claimed slot
+   // that is never published would stop every consumer behind it, so the
+   // construction must not throw
+   template<typename... Args>
+   bool try_emplace(Args&&... args) noexcept
+   {
+      static_assert(std::is_nothrow_constructible<T, Args...>::value,
+                    "mpmc_queue::try_emplace needs a noexcept constructor");
+      std::size_t pos = tail_.load(std::memory_order_relaxed);
+      cell* c;
+      for (;;) {
+         c = &cells_[pos & mask_];
+         const std::size_t seq = c->seq.load(std::memory_order_acquire);
+         const std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq - pos);
+         if (diff == 0) {
+            if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+               break;
+         } else if (diff < 0) {
+            return false;                             // full
+         } else {
+            pos = tail_.load(std::memory_order_relaxed);
+         }
+      }
+      ::new (c->value.bytes) T(std::forward<Args>(args)...);
+      c->seq.store(pos + 1, std::memory_order_release);
+      return true;
+   }
+
+   bool try_push(T&& value) noexcept { return try_emplace(std::move(value)); }
+
+   bool try_pop(T& out) noexcept
+   {
+      std::size_t pos = head_.load(std::memory_order_relaxed);
+      cell* c;
+      for (;;) {
+         c = &cells_[pos & mask_];
+         const std::size_t seq = c->seq.load(std::memory_order_acquire);
+         const std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq - (pos + 1));
+         if (diff == 0) {
+            if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+               break;
+         } else if (diff < 0) {
+            return false;                             // empty
+         } else {
+            pos = head_.load(std::memory_order_relaxed);
+         }
+      }
+      T* slot = c->value.get();
+      out = std::move(*slot);
+      slot->~T();
+      c->seq.store(pos + mask_ + 1, std::memory_order_release);
+      return true;
+   }
+
+   // claims the longest run of free cells, up to n, with one CAS
+   std::size_t push_batch(T* first, std::size_t n) noexcept
+   {
+      std::size_t pos = tail_.load(std::memory_order_relaxed);
+      std::size_t k;
+      for (;;) {
+         k = 0;
+         while (k < n && k <= mask_ &&
+                cells_[(pos + k) & mask_].seq.load(std::memory_order_acquire) == pos + k)
+            ++k;
+         if (k == 0) {
+            const std::size_t seq = cells_[pos & mask_].seq.load(std::memory_order_acquire);
+            if (static_cast<std::ptrdiff_t>(seq - pos) < 0) return 0;     // full
+            pos = tail_.load(std::memory_order_relaxed);
+            continue;
+         }
+         if (tail_.compare_exchange_weak(pos, pos + k, std::memory_order_relaxed))
+            break;
+      }
+      for (std::size_t i = 0; i < k; ++i) {
+         cell& c = cells_[(pos + i) & mask_];
+         ::new (c.value.bytes) T(std::move(first[i]));
+         c.seq.store(pos + i + 1, std::memory_order_release);
+      }
+      return k;
+   }
+
+   // claims the longest run of filled cells, up to n, with one CAS
+   std::size_t pop_batch(T* out, std::size_t n) noexcept
+   {
+      std::size_t pos = head_.load(std::memory_order_relaxed);
+      std::size_t k;
+      for (;;) {
+         k = 0;
+         while (k < n && k <= mask_ &&
+                cells_[(pos + k) & mask_].seq.load(std::memory_order_acquire) == pos + k + 1)
+            ++k;
+         if (k == 0) {
+            const std::size_t seq = cells_[pos & mask_].seq.load(std::memory_order_acquire);
+            if (static_cast<std::ptrdiff_t>(seq - (pos + 1)) < 0) return 0;   // empty
+            pos = head_.load(std::memory_order_relaxed);
+            continue;
+         }
+         if (head_.compare_exchange_weak(pos, pos + k, std::memory_order_relaxed))
+            break;
+      }
+      for (std::size_t i = 0; i < k; ++i) {
+         cell& c = cells_[(pos + i) & mask_];
+         T* slot = c.value.get();
+         out[i] = std::move(*slot);
+         slot->~T();
+         c.seq.store(pos + i + mask_ + 1, std::memory_order_release);
+      }
+      return k;
+   }
+
+   // a snapshot; exact only when no thread is active
+   std::size_t size() const noexcept
+   {
+      return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+   }
+
+private:
+   const std::size_t mask_;
+   const std::unique_ptr<cell[]> cells_;
+   alignas(ring_queue_detail::cacheLine) std::atomic<std::size_t> tail_{ 0 };
+   alignas(ring_queue_detail::cacheLine) std::atomic<std::size_t> head_{ 0 };
+};
+
+#endif // RING_QUEUE_H
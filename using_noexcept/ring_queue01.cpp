@@ -0,0 +1,214 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <utility>
+#include <type_traits>
+#include <cstdlib>
+#include <assert.h>
+
+#include "ring_queue.h"
+
+// Streaming Widgets between threads
+//
+// std::unique_ptr<Widget> is the ideal element for a queue between pipeline
+// stages: moving it is noexcept and costs two pointer writes, however big the
+// Widget. spsc_queue and mpmc_queue (ring_queue.h) accept only such elements.
+//
+// We pass two million Widgets through each queue with one producer and one
+// consumer (1:1), one producer and four consumers (1:N) and four of each
+// (N:N), one at a time and in batches of 32, and compare with the usual
+// std::mutex + std::condition_variable + std::deque queue. A nullptr marks the
+// end of the stream for each consumer.
+
+struct Widget {
+   long id;
+   std::string name;
+};
+
+using Item = std::unique_ptr<Widget>;
+
+static_assert(std::is_nothrow_move_constructible<Item>::value, "");
+
+// the baseline: blocking push and pop under one mutex
+template<typename T>
+class locked_queue {
+public:
+   explicit locked_queue(std::size_t capacity) : capacity_(capacity) {}
+
+   void push(T value)
+   {
+      std::unique_lock<std::mutex> lock(mutex_);
+      notFull_.wait(lock, [&] { return items_.size() < capacity_; });
+      items_.push_back(std::move(value));
+      lock.unlock();
+      notEmpty_.notify_one();
+   }
+
+   T pop()
+   {
+      std::unique_lock<std::mutex> lock(mutex_);
+      notEmpty_.wait(lock, [&] { return !items_.empty(); });
+      T value = std::move(items_.front());
+      items_.pop_front();
+      lock.unlock();
+      notFull_.notify_one();
+      return value;
+   }
+
+private:
+   std::size_t capacity_;
+   std::mutex mutex_;
+   std::condition_variable notEmpty_, notFull_;
+   std::deque<T> items_;
+};
+
+template<typename Q>
+void send(Q& q, Item* items, std::size_t n, std::size_t batch)
+{
+   if constexpr (std::is_same<Q, locked_queue<Item>>::value) {
+      (void)batch;
+      for (std::size_t i = 0; i < n; ++i)
+         q.push(std::move(items[i]));
+   } else if (batch > 1) {
+      for (std::size_t i = 0; i < n;) {
+         const std::size_t moved = q.push_batch(items + i, std::min(batch, n - i));
+         if (moved == 0) std::this_thread::yield();
+         i += moved;
+      }
+   } else {
+      for (std::size_t i = 0; i < n; ++i)
+         while (!q.try_push(std::move(items[i]))) std::this_thread::yield();
+   }
+}
+
+// receives into out until a nullptr arrives; returns the sum of the ids
+template<typename Q>
+long receive(Q& q, std::vector<Item>& out, std::size_t batch)
+{
+   long sum = 0;
+   if constexpr (std::is_same<Q, locked_queue<Item>>::value) {
+      (void)batch;
+      for (;;) {
+         Item w = q.pop();
+         if (!w) return sum;
+         sum += w->id;
+         out.push_back(std::move(w));
+      }
+   } else {
+      std::vector<Item> buffer(batch);
+      for (;;) {
+         const std::size_t got = batch > 1 ? q.pop_batch(buffer.data(), batch)
+                                           : q.try_pop(buffer[0]);
+         if (got == 0) {
+            std::this_thread::yield();
+            continue;
+         }
+         for (std::size_t i = 0; i < got; ++i) {
+            if (!buffer[i]) {
+               // everything behind the marker belongs to other consumers
+               for (std::size_t j = i + 1; j < got; ++j)
+                  send(q, &buffer[j], 1, 1);
+               return sum;
+            }
+            sum += buffer[i]->id;
+            out.push_back(std::move(buffer[i]));
+         }
+      }
+   }
+}
+
+template<typename Q>
+void run(const char* name, std::size_t n, unsigned producers, unsigned consumers,
+         std::size_t batch)
+{
+   Q q(1024);
+   std::vector<std::vector<Item>> input(producers), output(consumers);
+   for (unsigned p = 0; p < producers; ++p)
+      for (std::size_t i = p; i < n; i += producers)
+         input[p].push_back(std::make_unique<Widget>(Widget{ static_cast<long>(i), "widget" }));
+   for (auto& out : output)
+      out.reserve(n);
+   std::vector<long> sums(consumers);
+
+   const auto start = std::chrono::steady_clock::now();
+   std::vector<std::thread> threads;
+   for (unsigned c = 0; c < consumers; ++c)
+      threads.emplace_back([&, c] { sums[c] = receive(q, output[c], batch); });
+   std::vector<std::thread> senders;
+   for (unsigned p = 0; p < producers; ++p)
+      senders.emplace_back([&, p] { send(q, input[p].data(), input[p].size(), batch); });
+   for (auto& t : senders) t.join();
+   std::vector<Item> ends(consumers);
+   send(q, ends.data(), consumers, 1);
+   for (auto& t : threads) t.join();
+   const double ms = std::chrono::duration<double, std::milli>(
+      std::chrono::steady_clock::now() - start).count();
+
+   long total = 0;
+   std::size_t received = 0;
+   for (unsigned c = 0; c < consumers; ++c) {
+      total += sums[c];
+      received += output[c].size();
+   }
+   assert(received == n && total == static_cast<long>(n * (n - 1) / 2));
+   (void)total;
+   std::cout << "   " << name << " " << producers << ":" << consumers
+             << (batch > 1 ? ", batch " + std::to_string(batch) : std::string()) << ": " << ms
+             << " ms, " << n / ms / 1000 << " M items/s" << std::endl;
+}
+
+int main(const int argc, const char* argv[])
+{
+   {
+      spsc_queue<Item> s(3);
+      assert(s.capacity() == 4);
+      std::size_t pushed = 0, popped = 0;
+      for (long i = 0; i < 4; ++i)
+         pushed += s.try_push(std::make_unique<Widget>(Widget{ i, "w" }));
+      Item extra = std::make_unique<Widget>(Widget{ 9, "w" });
+      const bool overflowed = !s.try_push(std::move(extra));
+      assert(pushed == 4 && overflowed && extra);           // a failed push keeps the item
+      Item out;
+      for (long i = 0; s.try_pop(out); ++i, ++popped)
+         assert(out->id == i);
+      assert(popped == 4);
+
+      mpmc_queue<Item> m(8);
+      std::vector<Item> in(12), got(12);
+      for (long i = 0; i < 12; ++i) in[i] = std::make_unique<Widget>(Widget{ i, "w" });
+      const std::size_t first = m.push_batch(in.data(), 12);
+      assert(first == 8 && !in[7] && in[8]);
+      const std::size_t taken = m.pop_batch(got.data(), 5);
+      assert(taken == 5 && got[4]->id == 4);
+      const std::size_t second = m.push_batch(in.data() + 8, 4);        // wraps around
+      const std::size_t rest = m.pop_batch(got.data() + 5, 12);
+      assert(second == 4 && rest == 7 && got[11]->id == 11 && m.size() == 0);
+      (void)overflowed; (void)first; (void)taken; (void)second; (void)rest;
+
+      mpmc_queue<Item> leftover(4);                            // destroyed with the queue
+      leftover.try_push(std::make_unique<Widget>(Widget{ 1, "w" }));
+   }
+
+   const std::size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2000000;
+   std::cout << n << " std::unique_ptr<Widget>, " << std::thread::hardware_concurrency()
+             << " cores" << std::endl;
+   run<locked_queue<Item>>("mutex + condvar", n, 1, 1, 1);
+   run<spsc_queue<Item>>("spsc           ", n, 1, 1, 1);
+   run<spsc_queue<Item>>("spsc           ", n, 1, 1, 32);
+   run<mpmc_queue<Item>>("mpmc           ", n, 1, 1, 1);
+   run<mpmc_queue<Item>>("mpmc           ", n, 1, 1, 32);
+   run<locked_queue<Item>>("mutex + condvar", n, 1, 4, 1);
+   run<mpmc_queue<Item>>("mpmc           ", n, 1, 4, 1);
+   run<mpmc_queue<Item>>("mpmc           ", n, 1, 4, 32);
+   run<locked_queue<Item>>("mutex + condvar", n, 4, 4, 1);
+   run<mpmc_queue<Item>>("mpmc           ", n, 4, 4, 1);
+   run<mpmc_queue<Item>>("mpmc           ", n, 4, 4, 32);
+
+   return 0;
+}